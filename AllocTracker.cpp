@@ -0,0 +1,188 @@
+// File: AllocTracker.cpp
+//   By: John Holik
+// Desc: Implementation of the allocation counters and, when built with
+//       TETRIS_TRACK_ALLOCATIONS, the replacement operator new and delete
+
+#include "AllocTracker.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// counts of each phase, from every thread
+static std::atomic<uint64_t> phaseAllocations[ALLOC_PHASES];
+static std::atomic<uint64_t> phaseBytes[ALLOC_PHASES];
+
+static thread_local AllocPhase currentPhase = ALLOC_OTHER;
+
+const char* const PHASE_NAMES[ALLOC_PHASES] = {"other", "events", "update", "render"};
+
+#ifdef TETRIS_TRACK_ALLOCATIONS
+// local functions
+static void countAllocation(size_t bytes);
+#endif
+
+
+/**
+ * @return true if operator new is being counted in this build
+ */
+bool allocTrackingBuilt() {
+#ifdef TETRIS_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @param phase - phase the calling thread's allocations count against
+ */
+void setAllocPhase(AllocPhase phase) {
+    currentPhase = phase;
+}
+
+/**
+ * @return phase of the calling thread
+ */
+AllocPhase getAllocPhase() {
+    return currentPhase;
+}
+
+/**
+ * @param phase - phase to read
+ * @return allocations counted against the phase since the last call
+ */
+AllocCounts takeAllocCounts(AllocPhase phase) {
+    return {phaseAllocations[phase].exchange(0, std::memory_order_relaxed),
+            phaseBytes[phase].exchange(0, std::memory_order_relaxed)};
+}
+
+
+/**
+ * Property constructor
+ * @param updateBudget - most allocations the update phase may make in a
+ *                       frame, -1 for no budget
+ * @param warmupTicks - game ticks before the budget applies, while pools
+ *                      and arenas grow to size. Counted in ticks since
+ *                      the frames drawn in that time depend on the display.
+ */
+AllocReport::AllocReport(int64_t updateBudget, int warmupTicks)
+        : _updateBudget{updateBudget}, _warmupTicks{warmupTicks}, _ticks{0}, _frames{0}, _overBudget{0},
+          _total{}, _worst{} { }
+
+/**
+ * Take the counts of the frame that just ended
+ * @param ticks - game updates run in the frame
+ * @return allocations and bytes of every phase in the frame
+ */
+AllocCounts AllocReport::endFrame(int ticks) {
+    AllocCounts frame{0, 0};
+    ++_frames;
+    _ticks += ticks;
+    bool warm = _ticks > _warmupTicks;
+
+    for(int phase = 0; phase < ALLOC_PHASES; ++phase){
+        AllocCounts counts = takeAllocCounts(AllocPhase(phase));
+        frame.allocations += counts.allocations;
+        frame.bytes += counts.bytes;
+
+        _total[phase].allocations += counts.allocations;
+        _total[phase].bytes += counts.bytes;
+        if(warm){
+            _worst[phase].allocations = std::max(_worst[phase].allocations, counts.allocations);
+            _worst[phase].bytes = std::max(_worst[phase].bytes, counts.bytes);
+        }
+
+        if(warm && phase == ALLOC_UPDATE && _updateBudget >= 0 &&
+           counts.allocations > uint64_t(_updateBudget)){
+            ++_overBudget;
+        }
+    }
+    return frame;
+} // endFrame
+
+/**
+ * Print allocations per frame of each phase
+ * @param out - stream to print to
+ */
+void AllocReport::report(std::ostream& out) {
+    out << _frames << " frames" << (allocTrackingBuilt() ? "" : ", built without TETRIS_TRACK_ALLOCATIONS")
+        << std::endl;
+    if(_frames == 0){
+        return;
+    }
+
+    for(int phase = 0; phase < ALLOC_PHASES; ++phase){
+        out << PHASE_NAMES[phase] << ": " << double(_total[phase].allocations) / _frames
+            << " allocations, " << double(_total[phase].bytes) / _frames << " bytes per frame, worst "
+            << _worst[phase].allocations << " allocations, " << _worst[phase].bytes << " bytes" << std::endl;
+    }
+    if(_updateBudget >= 0){
+        out << _overBudget << " frames over the update budget of " << _updateBudget << std::endl;
+    }
+} // report
+
+
+#ifdef TETRIS_TRACK_ALLOCATIONS
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * @param bytes - size of an allocation made on this thread
+ */
+static void countAllocation(size_t bytes) {
+    phaseAllocations[currentPhase].fetch_add(1, std::memory_order_relaxed);
+    phaseBytes[currentPhase].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+
+// Replacement operator new and delete
+// ------------------------------------------------------------
+
+void* operator new(size_t bytes) {
+    countAllocation(bytes);
+    void* memory = std::malloc(bytes ? bytes : 1);
+    if(!memory){
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t bytes) {
+    return operator new(bytes);
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+    countAllocation(bytes);
+    return std::malloc(bytes ? bytes : 1);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t& tag) noexcept {
+    return operator new(bytes, tag);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    countAllocation(bytes);
+    size_t align = std::max(size_t(alignment), sizeof(void*));
+    void* memory = std::aligned_alloc(align, (bytes + align - 1) / align * align);
+    if(!memory){
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment) {
+    return operator new(bytes, alignment);
+}
+
+void operator delete(void* memory) noexcept {std::free(memory);}
+void operator delete[](void* memory) noexcept {std::free(memory);}
+void operator delete(void* memory, size_t) noexcept {std::free(memory);}
+void operator delete[](void* memory, size_t) noexcept {std::free(memory);}
+void operator delete(void* memory, std::align_val_t) noexcept {std::free(memory);}
+void operator delete[](void* memory, std::align_val_t) noexcept {std::free(memory);}
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {std::free(memory);}
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept {std::free(memory);}
+
+#endif
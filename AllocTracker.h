@@ -0,0 +1,80 @@
+// File: AllocTracker.h
+//   By: John Holik
+// Desc: Optional heap allocation tracking. Building with
+//       TETRIS_TRACK_ALLOCATIONS replaces the global operator new and
+//       delete with versions that count every allocation and its bytes
+//       against the main loop phase running on the thread (events,
+//       update or render). Threads outside a phase count as other. The
+//       main loop reads and resets the counts every frame, so an
+//       allocation creeping into the update path shows up right away
+//       and can fail a run that has an allocation budget. Without the
+//       define nothing is replaced and every count stays 0.
+
+#ifndef TETRIS3_ALLOCTRACKER_H
+#define TETRIS3_ALLOCTRACKER_H
+#include <cstdint>
+#include <ostream>
+
+enum AllocPhase{
+    ALLOC_OTHER,
+    ALLOC_EVENTS,
+    ALLOC_UPDATE,
+    ALLOC_RENDER,
+    ALLOC_PHASES
+};
+
+struct AllocCounts{
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+bool allocTrackingBuilt();
+
+void setAllocPhase(AllocPhase phase);
+AllocPhase getAllocPhase();
+AllocCounts takeAllocCounts(AllocPhase phase);
+
+
+// sets the thread's phase for the rest of the block
+class AllocPhaseScope {
+public:
+    explicit AllocPhaseScope(AllocPhase phase) : _previous{getAllocPhase()} {setAllocPhase(phase);}
+    ~AllocPhaseScope() {setAllocPhase(_previous);}
+
+    AllocPhaseScope(const AllocPhaseScope& other) = delete;
+    AllocPhaseScope& operator=(const AllocPhaseScope& rhs) = delete;
+
+private:
+    AllocPhase _previous;
+};
+
+
+// per frame allocation totals with an optional budget for the update phase
+class AllocReport {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    AllocReport(int64_t updateBudget, int warmupTicks);
+
+    // Accessors
+    // --------------------------------------------------------
+    int getOverBudget() {return _overBudget;}
+
+    // Methods
+    // --------------------------------------------------------
+    AllocCounts endFrame(int ticks);
+    void report(std::ostream& out);
+
+private:
+    int64_t _updateBudget;   // most update allocations in a frame, -1 for no budget
+    int _warmupTicks;        // game ticks before the budget applies
+    int _ticks;
+    int _frames;
+    int _overBudget;         // frames past warm up over the budget
+
+    AllocCounts _total[ALLOC_PHASES];
+    AllocCounts _worst[ALLOC_PHASES];  // most in one frame, after warm up
+};
+
+
+#endif //TETRIS3_ALLOCTRACKER_H
@@ -0,0 +1,74 @@
+// File: Arena.cpp
+//   By: John Holik
+// Desc: Implementation of the bump allocator
+
+#include "Arena.h"
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * Property constructor
+ * @param capacity - bytes in the first block
+ */
+Arena::Arena(size_t capacity) : _offset{0}, _used{0}, _capacity{capacity} {
+    _blocks.reserve(8);
+    _blocks.push_back({new char[capacity], capacity});
+} // property
+
+/**
+ * Destructor frees every block
+ */
+Arena::~Arena() {
+    for(Block& block : _blocks){
+        delete[] block.memory;
+    }
+} // destructor
+
+/**
+ * @param bytes - size of the allocation
+ * @param alignment - required alignment, a power of 2
+ * @return memory valid until reset()
+ */
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    size_t start = alignedOffset(_blocks.back(), _offset, alignment);
+
+    if(start + bytes > _blocks.back().size){
+        // out of room, add a block at least as big as everything so far
+        size_t size = std::max(_capacity, bytes + alignment);
+        _blocks.push_back({new char[size], size});
+        _capacity += size;
+        _offset = 0;
+        start = alignedOffset(_blocks.back(), 0, alignment);
+    }
+
+    _used += start + bytes - _offset;
+    _offset = start + bytes;
+    return _blocks.back().memory + start;
+} // allocate
+
+/**
+ * Release every allocation
+ */
+void Arena::reset() {
+    if(_blocks.size() > 1){
+        // merge into one block so the next run fits without growing
+        for(Block& block : _blocks){
+            delete[] block.memory;
+        }
+        _blocks.clear();
+        _blocks.push_back({new char[_capacity], _capacity});
+    }
+    _offset = 0;
+    _used = 0;
+} // reset
+
+/**
+ * @param block - block to allocate from
+ * @param offset - first free byte in the block
+ * @param alignment - required alignment, a power of 2
+ * @return first offset at or after offset with the alignment
+ */
+size_t Arena::alignedOffset(const Block& block, size_t offset, size_t alignment) {
+    auto address = reinterpret_cast<uintptr_t>(block.memory + offset);
+    return offset + ((alignment - address % alignment) % alignment);
+} // alignedOffset
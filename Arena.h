@@ -0,0 +1,62 @@
+// File: Arena.h
+//   By: John Holik
+// Desc: Bump allocator for scratch memory. Allocation moves a pointer
+//       and reset() releases everything at once. When a block runs out
+//       another is added, and the next reset() merges them into one
+//       block big enough for the whole run, so after the first few
+//       uses an arena never calls new again.
+
+#ifndef TETRIS3_ARENA_H
+#define TETRIS3_ARENA_H
+#include <cstddef>
+#include <vector>
+
+
+class Arena {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    explicit Arena(size_t capacity = 64 * 1024);
+
+    ~Arena(); // destructor
+
+    Arena(const Arena& other) = delete;
+    Arena& operator=(const Arena& rhs) = delete;
+
+    // Accessors
+    // --------------------------------------------------------
+    size_t getUsed() {return _used;}
+    size_t getCapacity() {return _capacity;}
+
+    // Methods
+    // --------------------------------------------------------
+    void* allocate(size_t bytes, size_t alignment);
+
+    /**
+     * Allocate uninitialized space for an array
+     * @param count - number of elements
+     * @return first element
+     */
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void reset();
+
+private:
+    struct Block{
+        char* memory;
+        size_t size;
+    };
+
+    std::vector<Block> _blocks; // last block is the one being used
+    size_t _offset;             // bytes used in the last block
+    size_t _used;               // bytes used in every block
+    size_t _capacity;           // bytes in every block
+
+    static size_t alignedOffset(const Block& block, size_t offset, size_t alignment);
+};
+
+
+#endif //TETRIS3_ARENA_H
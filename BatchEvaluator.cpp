@@ -0,0 +1,232 @@
+// File: BatchEvaluator.cpp
+//   By: John Holik
+// Desc: Implementation of the batched board evaluator
+
+#include "BatchEvaluator.h"
+#include <cstdlib>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// bits needed to hold a column height (up to GAME_ROWS)
+const int COUNTER_BITS = 5;
+
+// Vector helpers, the kernel is written once against these
+// ------------------------------------------------------------
+#if defined(__AVX2__)
+typedef __m256i VecI;
+typedef __m256 VecF;
+const int VEC_LANES = 8;
+
+static inline VecI loadI(const void* from) {return _mm256_load_si256(reinterpret_cast<const VecI*>(from));}
+static inline VecI setI(int value) {return _mm256_set1_epi32(value);}
+static inline VecI andI(VecI lhs, VecI rhs) {return _mm256_and_si256(lhs, rhs);}
+static inline VecI orI(VecI lhs, VecI rhs) {return _mm256_or_si256(lhs, rhs);}
+static inline VecI andNotI(VecI lhs, VecI rhs) {return _mm256_andnot_si256(lhs, rhs);}
+static inline VecI addI(VecI lhs, VecI rhs) {return _mm256_add_epi32(lhs, rhs);}
+static inline VecI subI(VecI lhs, VecI rhs) {return _mm256_sub_epi32(lhs, rhs);}
+static inline VecI absI(VecI value) {return _mm256_abs_epi32(value);}
+static inline VecI shiftRightI(VecI value, int bits) {return _mm256_srl_epi32(value, _mm_cvtsi32_si128(bits));}
+static inline VecF toF(VecI value) {return _mm256_cvtepi32_ps(value);}
+static inline VecF setF(float value) {return _mm256_set1_ps(value);}
+static inline VecF addF(VecF lhs, VecF rhs) {return _mm256_add_ps(lhs, rhs);}
+static inline VecF mulF(VecF lhs, VecF rhs) {return _mm256_mul_ps(lhs, rhs);}
+static inline void storeF(float* to, VecF value) {_mm256_storeu_ps(to, value);}
+
+#elif defined(__SSE2__)
+typedef __m128i VecI;
+typedef __m128 VecF;
+const int VEC_LANES = 4;
+
+static inline VecI loadI(const void* from) {return _mm_load_si128(reinterpret_cast<const VecI*>(from));}
+static inline VecI setI(int value) {return _mm_set1_epi32(value);}
+static inline VecI andI(VecI lhs, VecI rhs) {return _mm_and_si128(lhs, rhs);}
+static inline VecI orI(VecI lhs, VecI rhs) {return _mm_or_si128(lhs, rhs);}
+static inline VecI andNotI(VecI lhs, VecI rhs) {return _mm_andnot_si128(lhs, rhs);}
+static inline VecI addI(VecI lhs, VecI rhs) {return _mm_add_epi32(lhs, rhs);}
+static inline VecI subI(VecI lhs, VecI rhs) {return _mm_sub_epi32(lhs, rhs);}
+static inline VecI absI(VecI value) {
+    VecI sign = _mm_srai_epi32(value, 31);
+    return _mm_sub_epi32(_mm_xor_si128(value, sign), sign);
+}
+static inline VecI shiftRightI(VecI value, int bits) {return _mm_srl_epi32(value, _mm_cvtsi32_si128(bits));}
+static inline VecF toF(VecI value) {return _mm_cvtepi32_ps(value);}
+static inline VecF setF(float value) {return _mm_set1_ps(value);}
+static inline VecF addF(VecF lhs, VecF rhs) {return _mm_add_ps(lhs, rhs);}
+static inline VecF mulF(VecF lhs, VecF rhs) {return _mm_mul_ps(lhs, rhs);}
+static inline void storeF(float* to, VecF value) {_mm_storeu_ps(to, value);}
+
+#else
+typedef int32_t VecI;
+typedef float VecF;
+const int VEC_LANES = 1;
+
+static inline VecI loadI(const void* from) {return *reinterpret_cast<const VecI*>(from);}
+static inline VecI setI(int value) {return value;}
+static inline VecI andI(VecI lhs, VecI rhs) {return lhs & rhs;}
+static inline VecI orI(VecI lhs, VecI rhs) {return lhs | rhs;}
+static inline VecI andNotI(VecI lhs, VecI rhs) {return ~lhs & rhs;}
+static inline VecI addI(VecI lhs, VecI rhs) {return lhs + rhs;}
+static inline VecI subI(VecI lhs, VecI rhs) {return lhs - rhs;}
+static inline VecI absI(VecI value) {return std::abs(value);}
+static inline VecI shiftRightI(VecI value, int bits) {return VecI(uint32_t(value) >> bits);}
+static inline VecF toF(VecI value) {return float(value);}
+static inline VecF setF(float value) {return value;}
+static inline VecF addF(VecF lhs, VecF rhs) {return lhs + rhs;}
+static inline VecF mulF(VecF lhs, VecF rhs) {return lhs * rhs;}
+static inline void storeF(float* to, VecF value) {*to = value;}
+#endif
+
+// local functions
+static inline VecI byteCounts(VecI bits);
+static inline VecI counterAt(const VecI counter[], int column);
+
+
+/**
+ * Empty the batch
+ */
+void BoardBatch::clear() {
+    for(int row = 0; row < GAME_ROWS; ++row){
+        for(int index = 0; index < EVAL_BATCH; ++index){
+            rows[row][index] = ROW_EMPTY;
+        }
+    }
+    for(int index = 0; index < EVAL_BATCH; ++index){
+        lines[index] = 0;
+    }
+    count = 0;
+} // clear
+
+/**
+ * Copy a board into one lane of the batch
+ * @param index - lane, 0 .. EVAL_BATCH - 1
+ * @param board - board to copy
+ * @param lines - lines cleared by the placement that made the board
+ */
+void BoardBatch::load(int index, const SearchBoard& board, int lines) {
+    for(int row = 0; row < GAME_ROWS; ++row){
+        rows[row][index] = board.rows[row];
+    }
+    this->lines[index] = lines;
+    if(index >= count){
+        count = index + 1;
+    }
+} // load
+
+
+/**
+ * Score every board of a batch, same features and weights as evaluate()
+ * @param batch - boards to score
+ * @param weights - evaluation weights
+ * @param scores - receives batch.count scores
+ */
+void evaluateBatch(const BoardBatch& batch, const EvalWeights& weights, float scores[]) {
+    const VecI boardBits = setI(int(ROW_BOARD_BITS));
+
+    for(int lane = 0; lane < batch.count; lane += VEC_LANES){
+        // column heights, bit sliced: a column's height is set once,
+        // at the first filled cell found walking down from the top
+        VecI covered = setI(0);
+        VecI heights[COUNTER_BITS];
+        for(int bit = 0; bit < COUNTER_BITS; ++bit){
+            heights[bit] = setI(0);
+        }
+
+        // holes are counted per byte of each row mask and summed at the end
+        VecI holeBytes = setI(0);
+
+        for(int row = GAME_ROWS - 1; row >= 0; --row){
+            VecI filled = andI(loadI(&batch.rows[row][lane]), boardBits);
+            VecI top = andNotI(covered, filled);
+            for(int bit = 0; bit < COUNTER_BITS; ++bit){
+                if((row + 1) >> bit & 1){
+                    heights[bit] = orI(heights[bit], top);
+                }
+            }
+            holeBytes = addI(holeBytes, byteCounts(andNotI(filled, covered)));
+            covered = orI(covered, filled);
+        }
+        VecI holes = addI(holeBytes, shiftRightI(holeBytes, 16));
+        holes = andI(addI(holes, shiftRightI(holes, 8)), setI(0xFF));
+
+        VecI height = setI(0);
+        VecI bumpiness = setI(0);
+        VecI previous = setI(0);
+        for(int column = 0; column < GAME_COLUMNS; ++column){
+            VecI columnHeight = counterAt(heights, column);
+            height = addI(height, columnHeight);
+            if(column > 0){
+                bumpiness = addI(bumpiness, absI(subI(columnHeight, previous)));
+            }
+            previous = columnHeight;
+        }
+
+        VecF score = mulF(setF(weights.height), toF(height));
+        score = addF(score, mulF(setF(weights.lines), toF(loadI(&batch.lines[lane]))));
+        score = addF(score, mulF(setF(weights.holes), toF(holes)));
+        score = addF(score, mulF(setF(weights.bumpiness), toF(bumpiness)));
+
+        if(lane + VEC_LANES <= batch.count){
+            storeF(scores + lane, score);
+        } else {
+            alignas(32) float last[VEC_LANES];
+            storeF(last, score);
+            for(int index = lane; index < batch.count; ++index){
+                scores[index] = last[index - lane];
+            }
+        }
+    } // each vector of boards
+} // evaluateBatch
+
+/**
+ * Drop in replacement for calling evaluate() on each board of an array
+ * @param boards - boards to score
+ * @param lines - lines cleared reaching each board
+ * @param count - number of boards
+ * @param weights - evaluation weights
+ * @param scores - receives count scores
+ */
+void evaluateBoards(const SearchBoard boards[], const int lines[], int count,
+                    const EvalWeights& weights, float scores[]) {
+    BoardBatch batch;
+    batch.clear();
+    for(int first = 0; first < count; first += EVAL_BATCH){
+        batch.count = 0;
+        for(int index = first; index < count && index < first + EVAL_BATCH; ++index){
+            batch.load(index - first, boards[index], lines[index]);
+        }
+        evaluateBatch(batch, weights, scores + first);
+    }
+} // evaluateBoards
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * Count the set bits of each byte, the first steps of a SWAR popcount.
+ * Bytes stay below 256 when summed over every row of the board.
+ * @param bits - masks to count
+ * @return set bits of each byte, in that byte
+ */
+static inline VecI byteCounts(VecI bits) {
+    VecI pairs = subI(bits, andI(shiftRightI(bits, 1), setI(0x55555555)));
+    VecI nibbles = addI(andI(pairs, setI(0x33333333)), andI(shiftRightI(pairs, 2), setI(0x33333333)));
+    return andI(addI(nibbles, shiftRightI(nibbles, 4)), setI(0x0F0F0F0F));
+} // byteCounts
+
+/**
+ * @param counter - bit sliced column values, counter[bit] holds that bit of every column
+ * @param column - grid column
+ * @return the column's value in every lane
+ */
+static inline VecI counterAt(const VecI counter[], int column) {
+    int position = column + COLLISION_PAD_LEFT;
+    VecI value = setI(0);
+    for(int bit = 0; bit < COUNTER_BITS; ++bit){
+        // move the column's bit down to position 'bit' of the count
+        value = orI(value, andI(shiftRightI(counter[bit], position - bit), setI(1 << bit)));
+    }
+    return value;
+} // counterAt
@@ -0,0 +1,34 @@
+// File: BatchEvaluator.h
+//   By: John Holik
+// Desc: Scores many boards at once. Boards are stored as structure of
+//       arrays, row r of every board side by side, so one vector holds
+//       the same row of several boards. Column heights are kept bit
+//       sliced (one mask per height bit, one bit per column) and holes
+//       are counted with a SWAR popcount, so the whole board is scored
+//       with plain bit operations on every lane. Gives the same scores
+//       as evaluate().
+
+#ifndef TETRIS3_BATCHEVALUATOR_H
+#define TETRIS3_BATCHEVALUATOR_H
+#include "tetris.h"
+#include "SearchBoard.h"
+#include <cstdint>
+
+// boards scored per batch, a multiple of every vector width used
+const int EVAL_BATCH = 8;
+
+struct BoardBatch{
+    alignas(32) uint32_t rows[GAME_ROWS][EVAL_BATCH]; // row masks, one column per board
+    alignas(32) int32_t lines[EVAL_BATCH];            // lines cleared reaching each board
+    int count;                                        // boards loaded
+
+    void clear();
+    void load(int index, const SearchBoard& board, int lines);
+};
+
+void evaluateBatch(const BoardBatch& batch, const EvalWeights& weights, float scores[]);
+
+void evaluateBoards(const SearchBoard boards[], const int lines[], int count,
+                    const EvalWeights& weights, float scores[]);
+
+#endif //TETRIS3_BATCHEVALUATOR_H
@@ -0,0 +1,52 @@
+// File: BoardState.h
+//   By: John Holik
+// Desc: Compact plain copy of a game board. The grid is packed as a
+//       color index per cell so the whole board fits in a few hundred
+//       bytes and can be sent or stored without any of the SFML shapes.
+//       It also holds the frame counters and random generator position,
+//       so a board restored from it plays on exactly as the original.
+
+#ifndef TETRIS3_BOARDSTATE_H
+#define TETRIS3_BOARDSTATE_H
+#include "tetris.h"
+#include "Tetromino.h"
+#include <cstdint>
+
+// color index of a grid cell, filled cells use their piece's color
+// (see PieceSet.h), ShapeType + 1 for the standard shapes
+const int CELL_EMPTY = 0;
+const int CELL_GARBAGE = Tetromino::SHAPE_COUNT + 1;
+const int CELL_BITS = 4; // bits per cell in BoardState::cells
+const uint64_t CELL_MASK = (1u << CELL_BITS) - 1u;
+
+struct BoardState{
+    uint64_t cells[GAME_ROWS]; // color index of each column, column 0 in the low bits
+    int8_t shape;              // ShapeType of the current shape, SHAPE_NONE between shapes
+    int8_t nextShape;          // ShapeType of the next shape
+    int8_t rotation;           // rotations of the current shape
+    int8_t column;             // grid column of the current shape's left side
+    int8_t row;                // grid row of the current shape's top row
+
+    int8_t gameOver;
+    int8_t pendingGarbage;     // garbage rows waiting for the shape to lock
+    int8_t garbageHole;
+    int16_t newShapeFrame;     // FrameCounters::newShape
+    int16_t autoMoveFrame;     // FrameCounters::autoMove
+    int32_t linesCleared;
+
+    // the whole shape generator: its seed and the number of shapes drawn
+    uint32_t seed;
+    uint32_t shapesGenerated;
+};
+
+/**
+ * @param state - board to read
+ * @param row - grid row (0 is the bottom)
+ * @param column - grid column
+ * @return color index of the cell
+ */
+inline int cellAt(const BoardState& state, int row, int column){
+    return int((state.cells[row] >> (column * CELL_BITS)) & CELL_MASK);
+}
+
+#endif //TETRIS3_BOARDSTATE_H
@@ -0,0 +1,217 @@
+// File: Collision.cpp
+//   By: John Holik
+// Desc: Implementation of the bitmask collision kernel
+
+#include "Collision.h"
+#include "PieceSet.h"
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// local functions
+static uint32_t rowAt(const uint32_t rows[], int row);
+
+
+// Mask construction
+// ------------------------------------------------------------
+
+/**
+ * Convert the Matrix of a shape into row bit masks and pre-shift
+ * them for each of the offsets tested by legalColumns()
+ * @param shape - shape to convert (at its current rotation)
+ * @param mask - receives the shape's masks
+ */
+void buildShapeMask(Tetromino& shape, ShapeMask& mask) {
+    mask.rows = shape.getRows();
+    mask.columns = shape.getColumns();
+
+    for(int row = 0; row < SHAPE_MAX_SIZE; ++row){
+        uint32_t bits = 0;
+
+        if(row < mask.rows){
+            for(int column = 0; column < mask.columns; ++column){
+                if(shape.hasBlock(row, column)){
+                    bits |= 1u << column;
+                }
+            } // each column
+        }
+        mask.bits[row] = bits;
+
+        for(int offset = 0; offset < COLLISION_OFFSETS; ++offset){
+            mask.shifted[row][offset] = bits << offset;
+        } // each offset
+    } // each row
+} // buildShapeMask
+
+
+/**
+ * Masks are built with the piece set (see PieceSet.h)
+ * @param type - shape type, or piece number in the piece set
+ * @param rotation - number of rotations from the starting position
+ * @return mask of the shape at that rotation
+ */
+const ShapeMask& shapeMask(Tetromino::ShapeType type, int rotation) {
+    return pieceSet().getMask(type, rotation);
+} // shapeMask
+
+
+// Kernel
+// ------------------------------------------------------------
+
+/**
+ * Test a single location. Matches TetrisBoard::hasCollision(), a block
+ * collides if it is outside the walls, below the floor or on a filled cell
+ * @param rows - padded row masks, index 0 is the bottom row
+ * @param mask - shape to test
+ * @param column - grid column of the shape's left side
+ * @param row - grid row of the shape's top row
+ * @return true if there is a collision
+ */
+bool hasCollision(const uint32_t rows[], const ShapeMask& mask,
+                  int column, int row) {
+    int offset = column + COLLISION_PAD_LEFT;
+    if(offset < 0 || offset >= COLLISION_OFFSETS){
+        return true; // every block is inside a wall
+    }
+
+    uint32_t collide = 0;
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        collide |= rowAt(rows, row - shapeRow) & mask.shifted[shapeRow][offset];
+    }
+    return collide != 0;
+} // hasCollision
+
+
+/**
+ * Test every horizontal offset of a shape at one grid row in a single pass
+ * @param rows - padded row masks, index 0 is the bottom row
+ * @param mask - shape to test
+ * @param row - grid row of the shape's top row
+ * @return bit (column + COLLISION_PAD_LEFT) set for each legal column
+ */
+unsigned int legalColumns(const uint32_t rows[], const ShapeMask& mask, int row) {
+    unsigned int legal = 0;
+
+#if defined(__AVX2__)
+    __m256i collideLow = _mm256_setzero_si256();
+    __m256i collideHigh = _mm256_setzero_si256();
+
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        __m256i board = _mm256_set1_epi32(int(rowAt(rows, row - shapeRow)));
+        const __m256i* shifted = reinterpret_cast<const __m256i*>(mask.shifted[shapeRow]);
+
+        collideLow = _mm256_or_si256(collideLow, _mm256_and_si256(board, _mm256_load_si256(shifted)));
+        collideHigh = _mm256_or_si256(collideHigh, _mm256_and_si256(board, _mm256_load_si256(shifted + 1)));
+    }
+
+    __m256i zero = _mm256_setzero_si256();
+    legal = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(collideLow, zero))));
+    legal |= unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(collideHigh, zero)))) << 8;
+
+#elif defined(__SSE2__)
+    __m128i collide[COLLISION_OFFSETS / 4];
+    for(int lane = 0; lane < COLLISION_OFFSETS / 4; ++lane){
+        collide[lane] = _mm_setzero_si128();
+    }
+
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        __m128i board = _mm_set1_epi32(int(rowAt(rows, row - shapeRow)));
+        const __m128i* shifted = reinterpret_cast<const __m128i*>(mask.shifted[shapeRow]);
+
+        for(int lane = 0; lane < COLLISION_OFFSETS / 4; ++lane){
+            collide[lane] = _mm_or_si128(collide[lane], _mm_and_si128(board, _mm_load_si128(shifted + lane)));
+        }
+    }
+
+    __m128i zero = _mm_setzero_si128();
+    for(int lane = 0; lane < COLLISION_OFFSETS / 4; ++lane){
+        unsigned int free = unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(collide[lane], zero))));
+        legal |= free << (lane * 4);
+    }
+
+#else
+    uint32_t collide[COLLISION_OFFSETS] = {0};
+
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        uint32_t board = rowAt(rows, row - shapeRow);
+        for(int offset = 0; offset < COLLISION_OFFSETS; ++offset){
+            collide[offset] |= board & mask.shifted[shapeRow][offset];
+        }
+    }
+
+    for(int offset = 0; offset < COLLISION_OFFSETS; ++offset){
+        if(collide[offset] == 0){
+            legal |= 1u << offset;
+        }
+    }
+#endif
+
+    return legal & LEGAL_COLUMNS_ALL;
+} // legalColumns
+
+
+/**
+ * Find how far a shape falls. Above the stack only the walls are set,
+ * which the shape already clears, so it falls there without testing.
+ * From there every block row is tested at each row down, a shape with
+ * a gap inside a column can't pass over a filled cell in the gap.
+ * @param rows - padded row masks, index 0 is the bottom row
+ * @param mask - shape to drop, must fit at column and row
+ * @param column - grid column of the shape's left side
+ * @param row - grid row of the shape's top row
+ * @param maxRows - most rows to fall
+ * @return rows the shape can fall, 0 .. maxRows
+ */
+int dropDistance(const uint32_t rows[], const ShapeMask& mask,
+                 int column, int row, int maxRows) {
+    int offset = column + COLLISION_PAD_LEFT;
+
+    int bottom = 0; // lowest shape row with a block
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        if(mask.bits[shapeRow]){
+            bottom = shapeRow;
+        }
+    }
+
+    // highest row with a filled cell at or under the shape
+    int stackTop = std::min(row, GAME_ROWS - 1);
+    while(stackTop >= 0 && (rows[stackTop] & ROW_BOARD_BITS) == 0){
+        --stackTop;
+    }
+
+    int fall = std::max(0, std::min(row - bottom - stackTop - 1, maxRows));
+    while(fall < maxRows){
+        int top = row - fall - 1; // grid row of the shape's top row one lower
+        uint32_t collide = 0;
+        for(int shapeRow = 0; shapeRow <= bottom; ++shapeRow){
+            collide |= rowAt(rows, top - shapeRow) & mask.shifted[shapeRow][offset];
+        }
+        if(collide){
+            break;
+        }
+        ++fall;
+    } // each row down
+
+    return fall;
+} // dropDistance
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * @param rows - padded row masks
+ * @param row - grid row, may be outside the board
+ * @return padded mask of the row, floor below the board, open above it
+ */
+static uint32_t rowAt(const uint32_t rows[], int row) {
+    if(row < 0){
+        return ROW_FLOOR;
+    }
+    if(row >= GAME_ROWS){
+        return ROW_EMPTY;
+    }
+    return rows[row];
+} // rowAt
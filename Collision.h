@@ -0,0 +1,68 @@
+// File: Collision.h
+//   By: John Holik
+// Desc: Bitmask collision kernel for the game board. Each grid row is
+//       kept as a padded bit mask with the walls already set, so a
+//       shape can be tested against every horizontal offset of the
+//       board at once. Uses AVX2 or SSE2 when available with a scalar
+//       fallback that produces the same result.
+
+#ifndef TETRIS3_COLLISION_H
+#define TETRIS3_COLLISION_H
+#include "tetris.h"
+#include "Tetromino.h"
+#include <cstdint>
+
+// largest shape (rows x columns) the collision masks can hold
+const int SHAPE_MAX_SIZE = 5;
+
+// wall bits to the left of column 0 so shapes can hang off the left wall
+const int COLLISION_PAD_LEFT = SHAPE_MAX_SIZE - 1;
+
+// number of horizontal offsets tested in one pass (x = -PAD_LEFT .. )
+const int COLLISION_OFFSETS = 16;
+
+// padded row layout: [left wall][GAME_COLUMNS board bits][right wall]
+const uint32_t ROW_BOARD_BITS = ((1u << GAME_COLUMNS) - 1u) << COLLISION_PAD_LEFT;
+const uint32_t ROW_EMPTY = ~ROW_BOARD_BITS; // walls only
+const uint32_t ROW_FLOOR = 0xFFFFFFFFu;     // everything below row 0
+
+// bit i of a legal columns mask is the column offset i - COLLISION_PAD_LEFT
+const unsigned int LEGAL_COLUMNS_ALL =
+        (1u << (GAME_COLUMNS + COLLISION_PAD_LEFT)) - 1u;
+
+struct ShapeMask{
+    int rows;                         // rows used by the shape
+    int columns;                      // columns used by the shape
+    uint32_t bits[SHAPE_MAX_SIZE];    // bit c set = block in column c
+
+    // bits[row] pre-shifted for every offset the kernel tests
+    alignas(32) uint32_t shifted[SHAPE_MAX_SIZE][COLLISION_OFFSETS];
+};
+
+// Mask construction
+// ------------------------------------------------------------
+void buildShapeMask(Tetromino& shape, ShapeMask& mask);
+
+const ShapeMask& shapeMask(Tetromino::ShapeType type, int rotation);
+
+// Kernel
+// ------------------------------------------------------------
+bool hasCollision(const uint32_t rows[], const ShapeMask& mask,
+                  int column, int row);
+
+unsigned int legalColumns(const uint32_t rows[], const ShapeMask& mask, int row);
+
+int dropDistance(const uint32_t rows[], const ShapeMask& mask,
+                 int column, int row, int maxRows);
+
+/**
+ * @param legal - mask returned by legalColumns()
+ * @param column - grid column of the shape's left side
+ * @return true if the column offset is set in the mask
+ */
+inline bool isLegalColumn(unsigned int legal, int column){
+    int bit = column + COLLISION_PAD_LEFT;
+    return bit >= 0 && bit < COLLISION_OFFSETS && (legal >> bit) & 1u;
+}
+
+#endif //TETRIS3_COLLISION_H
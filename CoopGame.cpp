@@ -0,0 +1,350 @@
+// File: CoopGame.cpp
+//   By: John Holik
+// Desc: Implementation of the cooperative mode
+
+#include "CoopGame.h"
+#include "TetrisBoard.h"
+#include "GameInput.h"
+#include "KickTable.h"
+#include "PieceSet.h"
+#include "Trace.h"
+#include <algorithm>
+
+// the first two players use the board keys and the arrow keys,
+// in InputBits order: rotate, left, right, down
+const sf::Keyboard::Key COOP_KEYS[2][4] = {
+        {sf::Keyboard::Key::Space, sf::Keyboard::Key::A, sf::Keyboard::Key::D, sf::Keyboard::Key::S},
+        {sf::Keyboard::Key::Up, sf::Keyboard::Key::Left, sf::Keyboard::Key::Right, sf::Keyboard::Key::Down}};
+
+// largest window the board is scaled down to fit
+const float COOP_WINDOW_WIDTH = 1600.f;
+const float COOP_WINDOW_HEIGHT = 960.f;
+
+
+// Constructors
+// ------------------------------------------------------------
+
+/**
+ * Property constructor sets up the shared board
+ * @param players - number of players, 1 to COOP_MAX_PLAYERS
+ * @param humans - players on the keyboard (0-2), the rest press random keys
+ * @param columns - board width, up to WIDE_MAX_COLUMNS
+ * @param rows - board height, up to WIDE_MAX_ROWS
+ * @param seed - picks the sequence of shapes
+ */
+CoopGame::CoopGame(int players, int humans, int columns, int rows, unsigned int seed)
+        : _board{columns, rows} {
+    players = std::max(1, std::min(players, COOP_MAX_PLAYERS));
+
+    for(int player = 0; player < players; ++player){
+        _shapes.push_back(CoopShape{Tetromino::SHAPE_NONE, 0, 0, 0, 0, FRAMES_NEW_SHAPE});
+        bool human = player < std::min(humans, 2);
+        _randomInputs.push_back(human ? nullptr : new RandomInputSource(seed + unsigned(player)));
+        _inputs.push_back(INPUT_NONE);
+    }
+
+    _overlay = new uint64_t[_board.getRows()];
+    std::fill(_overlay, _overlay + _board.getRows(), uint64_t(0));
+
+    _gameOver = false;
+    _linesCleared = 0;
+    _tick = 0;
+    _seed = seed;
+    _shapesGenerated = 0;
+
+    _shapeBlock.setSize(sf::Vector2f(BLOCK_SIZE, BLOCK_SIZE));
+} // property
+
+/**
+ * Destructor cleans up the overlay and input sources
+ */
+CoopGame::~CoopGame() {
+    delete[] _overlay;
+    _overlay = nullptr;
+
+    for(RandomInputSource* input : _randomInputs){
+        delete input;
+    }
+} // destructor
+
+
+// Methods
+// ------------------------------------------------------------
+
+/**
+ * @return window size that fits the board, scaled down if it is large
+ */
+sf::Vector2u CoopGame::getWindowSize() {
+    float width = float((_board.getColumns() + 2) * BLOCK_SIZE);
+    float height = float((_board.getRows() + 2) * BLOCK_SIZE);
+    float scale = std::min({1.f, COOP_WINDOW_WIDTH / width, COOP_WINDOW_HEIGHT / height});
+
+    return sf::Vector2u(unsigned(width * scale), unsigned(height * scale));
+} // getWindowSize
+
+
+/**
+ * Run one tick from the keyboard
+ * @param input - keyboard state, player 1 uses the board keys and
+ *                player 2 the arrow keys
+ * @return true if the game should end
+ */
+bool CoopGame::Update(KeyPressedState input[]) {
+    BoardState none{};
+
+    for(int player = 0; player < getPlayers(); ++player){
+        unsigned int bits = INPUT_NONE;
+        if(_randomInputs[player]){
+            bits = _randomInputs[player]->nextInput(none, _tick);
+        } else {
+            for(int key = 0; key < 4; ++key){
+                if(isKeyPressed(input, COOP_KEYS[player][key])){
+                    bits |= 1u << key;
+                }
+            }
+        }
+        _inputs[player] = bits;
+    } // each player
+
+    return update(_inputs.data());
+} // Update
+
+
+/**
+ * Run one tick. The players move in order, each against the filled
+ * cells and every other shape. Then all the shapes resting on the stack
+ * lock together and the full lines are cleared once.
+ * @param inputs - InputBits pressed by each player this tick
+ * @return true if the game is over
+ */
+bool CoopGame::update(const unsigned int inputs[]) {
+    TRACE_SCOPE("CoopGame::update");
+    if(_gameOver){
+        return true;
+    }
+
+    for(int player = 0; player < getPlayers(); ++player){
+        CoopShape& shape = _shapes[player];
+
+        if(shape.shape != Tetromino::SHAPE_NONE){
+            moveShape(player, inputs[player]);
+        } else if(shape.newShape < FRAMES_NEW_SHAPE){
+            ++shape.newShape;
+        } else if(!spawnShape(player)){
+            _gameOver = true; // no room on the stack for the new shape
+        }
+    } // each player
+
+    // a shape resting on one that locks now rests on the stack too,
+    // so keep going until no more lock this tick
+    bool locked = false;
+    bool locking = true;
+    while(locking){
+        locking = false;
+        for(CoopShape& shape : _shapes){
+            if(shape.shape != Tetromino::SHAPE_NONE && restsOnStack(shape)){
+                toggleOverlay(shape);
+                _board.lockShape(shapeMask(Tetromino::ShapeType(shape.shape), shape.rotation),
+                                 shape.column, shape.row, pieceSet().getPiece(shape.shape).color);
+
+                shape.shape = Tetromino::SHAPE_NONE;
+                shape.rotation = 0;
+                shape.newShape = 0;
+                locking = true;
+                locked = true;
+            }
+        }
+    } // until no shape locks
+
+    int cleared = locked ? _board.clearLines() : 0;
+    _linesCleared += cleared;
+
+    // the stack above the cleared lines moved down, lift any moving shape
+    // it now covers back out of it
+    for(int player = 0; cleared > 0 && player < getPlayers(); ++player){
+        CoopShape& shape = _shapes[player];
+        if(shape.shape == Tetromino::SHAPE_NONE){
+            continue;
+        }
+
+        toggleOverlay(shape);
+        int lift = 0;
+        while(lift <= cleared && !fits(shape, shape.column, shape.row + lift, shape.rotation)){
+            ++lift;
+        }
+        if(lift > cleared){
+            _gameOver = true; // buried with nowhere to go
+        } else {
+            shape.row += lift;
+        }
+        toggleOverlay(shape);
+    } // each player
+
+    ++_tick;
+    return _gameOver;
+} // update
+
+
+/**
+ * Draw the stack in one call and the moving shapes over it
+ * @param window - window to draw on
+ */
+void CoopGame::render(sf::RenderWindow& window) {
+    TRACE_SCOPE("CoopGame::render");
+    float width = float((_board.getColumns() + 2) * BLOCK_SIZE);
+    float height = float((_board.getRows() + 2) * BLOCK_SIZE);
+    window.setView(sf::View{sf::FloatRect(0.f, 0.f, width, height)});
+
+    _board.render(window, sf::Vector2f(GRID_LEFT, GRID_TOP), BLOCK_SIZE);
+
+    for(const CoopShape& shape : _shapes){
+        if(shape.shape == Tetromino::SHAPE_NONE){
+            continue;
+        }
+
+        const ShapeMask& mask = shapeMask(Tetromino::ShapeType(shape.shape), shape.rotation);
+        _shapeBlock.setFillColor(cellColor(pieceSet().getPiece(shape.shape).color));
+        for(int row = 0; row < mask.rows; ++row){
+            for(int column = 0; column < mask.columns; ++column){
+                if((mask.bits[row] >> column) & 1u){
+                    _shapeBlock.setPosition(GRID_LEFT + (shape.column + column) * BLOCK_SIZE,
+                                            GRID_TOP + (_board.getRows() - 1 - shape.row + row) * BLOCK_SIZE);
+                    window.draw(_shapeBlock);
+                }
+            } // each column
+        } // each row
+    } // each shape
+
+    window.setView(window.getDefaultView());
+} // render
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * Rotate, move and drop one player's shape. The shape is taken out of
+ * the overlay while it moves so it doesn't collide with itself.
+ * @param player - player moving
+ * @param input - InputBits pressed this tick
+ */
+void CoopGame::moveShape(int player, unsigned int input) {
+    CoopShape& shape = _shapes[player];
+    toggleOverlay(shape);
+
+    if(input & INPUT_ROTATE){
+        // first SRS kick the turned shape fits at
+        const KickList& kicks = rotationKicks(Tetromino::ShapeType(shape.shape), shape.rotation);
+        for(int test = 0; test < kicks.count; ++test){
+            int column = shape.column + kicks.kicks[test].column;
+            int row = shape.row + kicks.kicks[test].row;
+            if(fits(shape, column, row, shape.rotation + 1)){
+                shape.column = column;
+                shape.row = row;
+                shape.rotation = (shape.rotation + 1) % 4;
+                break;
+            }
+        }
+    } // rotate
+
+    if((input & INPUT_LEFT) && fits(shape, shape.column - 1, shape.row, shape.rotation)){
+        shape.column -= 1;
+    } else if((input & INPUT_RIGHT) && fits(shape, shape.column + 1, shape.row, shape.rotation)){
+        shape.column += 1;
+    }
+
+    if((input & INPUT_DOWN) || shape.autoMove >= FRAMES_AUTO_MOVE){
+        if(fits(shape, shape.column, shape.row - 1, shape.rotation)){
+            shape.row -= 1;
+        }
+        shape.autoMove = 0;
+    } else {
+        shape.autoMove++;
+    }
+
+    toggleOverlay(shape);
+} // moveShape
+
+
+/**
+ * Bring in a player's next shape at the top of their part of the board
+ * @param player - player whose shape to spawn
+ * @return false if the stack is in the way, the game is over. If another
+ *         shape is in the way it waits for the next tick instead.
+ */
+bool CoopGame::spawnShape(int player) {
+    CoopShape next = _shapes[player];
+    next.shape = shapeAt(_seed, _shapesGenerated);
+    next.rotation = 0;
+    next.row = _board.getRows() - 1;
+    next.autoMove = 0;
+
+    const ShapeMask& mask = shapeMask(Tetromino::ShapeType(next.shape), next.rotation);
+    next.column = std::max(0, std::min(spawnColumn(player), _board.getColumns() - mask.columns));
+
+    if(_board.hasCollision(mask, next.column, next.row)){
+        return false;
+    }
+    if(fits(next, next.column, next.row, next.rotation)){
+        ++_shapesGenerated;
+        _shapes[player] = next;
+        toggleOverlay(_shapes[player]);
+    }
+    return true;
+} // spawnShape
+
+
+/**
+ * @param shape - moving shape, not in the overlay
+ * @param column - column to test
+ * @param row - row to test
+ * @param rotation - rotation to test
+ * @return true if the shape fits there, clear of the filled cells, the
+ *         other shapes and the top of the board
+ */
+bool CoopGame::fits(const CoopShape& shape, int column, int row, int rotation) {
+    const ShapeMask& mask = shapeMask(Tetromino::ShapeType(shape.shape), rotation);
+    const PieceBox& box = pieceSet().getBox(shape.shape, rotation);
+
+    return row - box.top < _board.getRows() && !_board.hasCollision(mask, column, row, _overlay);
+} // fits
+
+
+/**
+ * @param shape - moving shape
+ * @return true if the shape can't move down because of the filled cells
+ *         or the floor, resting on another moving shape doesn't count
+ */
+bool CoopGame::restsOnStack(const CoopShape& shape) {
+    return _board.hasCollision(shapeMask(Tetromino::ShapeType(shape.shape), shape.rotation),
+                               shape.column, shape.row - 1);
+} // restsOnStack
+
+
+/**
+ * Add a shape's cells to the overlay, or take them out if they are in it
+ * @param shape - moving shape
+ */
+void CoopGame::toggleOverlay(const CoopShape& shape) {
+    const ShapeMask& mask = shapeMask(Tetromino::ShapeType(shape.shape), shape.rotation);
+
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        int gridRow = shape.row - shapeRow;
+        uint64_t placed = 0;
+        if(gridRow >= 0 && gridRow < _board.getRows() &&
+           _board.placeRow(mask.bits[shapeRow], shape.column, placed)){
+            _overlay[gridRow] ^= placed;
+        }
+    } // each shape row
+} // toggleOverlay
+
+
+/**
+ * @param player - player number
+ * @return column a player's shapes start in, the middle of their share
+ *         of the board's width
+ */
+int CoopGame::spawnColumn(int player) {
+    int share = _board.getColumns() / getPlayers();
+    return player * share + share / 2 - 2;
+} // spawnColumn
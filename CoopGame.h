@@ -0,0 +1,90 @@
+// File: CoopGame.h
+//   By: John Holik
+// Desc: Cooperative mode. Several players share one WideBoard, each
+//       moving their own shape at the same time. The cells of every
+//       moving shape are kept in an overlay of row masks, so a move
+//       is tested against the filled cells and the other shapes with
+//       the same few mask tests however many players there are. Each
+//       tick the players move in order, then every shape resting on
+//       the stack locks and the lines are cleared once for all of them.
+
+#ifndef TETRIS3_COOPGAME_H
+#define TETRIS3_COOPGAME_H
+#include "tetris.h"
+#include "WideBoard.h"
+#include "InputSource.h"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+const int COOP_MAX_PLAYERS = 16;
+const int COOP_COLUMNS_PER_PLAYER = 8; // default board width for each player
+const int COOP_ROWS = 30;              // default board height
+
+struct CoopShape{
+    int shape;      // piece number, SHAPE_NONE while waiting to spawn
+    int rotation;
+    int column;     // column of the shape's left side
+    int row;        // row of the shape's top row
+    int autoMove;   // ticks since it last moved down
+    int newShape;   // ticks waited for the next shape
+};
+
+
+class CoopGame {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    CoopGame(int players, int humans, int columns, int rows, unsigned int seed);
+
+    ~CoopGame(); // destructor
+
+    CoopGame(const CoopGame& other) = delete;
+    CoopGame& operator=(const CoopGame& rhs) = delete;
+
+    // Accessors
+    // --------------------------------------------------------
+    int getPlayers() {return int(_shapes.size());}
+    int getLinesCleared() {return _linesCleared;}
+    bool isGameOver() {return _gameOver;}
+    const CoopShape& getShape(int player) {return _shapes[player];}
+    WideBoard& getBoard() {return _board;}
+    sf::Vector2u getWindowSize();
+
+    // Methods
+    // --------------------------------------------------------
+    bool Update(KeyPressedState input[]);
+    bool update(const unsigned int inputs[]);
+
+    void render(sf::RenderWindow& window);
+
+// Private
+// ------------------------------------------------------------
+private:
+    WideBoard _board;
+    std::vector<CoopShape> _shapes;
+    std::vector<RandomInputSource*> _randomInputs; // nullptr for keyboard players
+    std::vector<unsigned int> _inputs;             // keys pressed by each player this tick
+
+    uint64_t* _overlay;  // cells of every moving shape by row
+
+    bool _gameOver;
+    int _linesCleared;
+    uint32_t _tick;
+
+    // the shapes come from one sequence, in the order they spawn
+    unsigned int _seed;
+    unsigned int _shapesGenerated;
+
+    sf::RectangleShape _shapeBlock;
+
+    void moveShape(int player, unsigned int input);
+    bool spawnShape(int player);
+    bool fits(const CoopShape& shape, int column, int row, int rotation);
+    bool restsOnStack(const CoopShape& shape);
+    void toggleOverlay(const CoopShape& shape);
+    int spawnColumn(int player);
+};
+
+
+#endif //TETRIS3_COOPGAME_H
@@ -0,0 +1,106 @@
+// File: DatasetGenerator.cpp
+//   By: John Holik
+// Desc: Implementation of the training dataset generator
+
+#include "DatasetGenerator.h"
+#include "TetrisBot.h"
+#include "Trace.h"
+#include <algorithm>
+#include <random>
+
+
+/**
+ * Property constructor
+ * @param pool - threads to play on
+ * @param writer - open writer to stream samples to
+ * @param policy - how shapes are placed
+ * @param seed - seed of the first game, game n uses seed + n
+ */
+DatasetGenerator::DatasetGenerator(WorkStealingPool& pool, DatasetWriter& writer,
+                                   DatasetPolicy policy, uint32_t seed)
+        : _pool{pool}, _writer{writer}, _policy{policy}, _seed{seed}, _samples{0} { }
+
+/**
+ * Play games until done. Games are split into groups, each group
+ * filling blocks on the thread that plays it.
+ * @param games - number of games to play
+ */
+void DatasetGenerator::playGames(int games) {
+    // a group holds a block while it plays, and the bot's searches may
+    // start other groups on the same thread, so keep enough blocks free
+    // for every group to hold one and swap it for another
+    int tasks = std::min(games, DATASET_QUEUE_BLOCKS / 2);
+
+    auto playGroup = [&](int task) {
+        SampleBlock* block = _writer.takeBlock();
+
+        int first = int(int64_t(games) * task / tasks);
+        int last = int(int64_t(games) * (task + 1) / tasks);
+        for(int game = first; game < last; ++game){
+            playGame(_seed + uint32_t(game), block);
+        }
+
+        _writer.submit(block);
+    };
+    _pool.run(tasks, playGroup);
+} // playGames
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * Play one game, adding a sample for each placement
+ * @param seed - picks the shapes
+ * @param block - block being filled, replaced by a new one when full
+ */
+void DatasetGenerator::playGame(uint32_t seed, SampleBlock*& block) {
+    TRACE_SCOPE("DatasetGenerator::playGame");
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<> shapes(0, Tetromino::SHAPE_COUNT - 1);
+
+    TetrisBot bot{_pool};
+    bot.setMaxDepth(DATASET_SEARCH_DEPTH);
+
+    SearchBoard board{};
+    board.clear();
+    auto shape = Tetromino::ShapeType(shapes(generator));
+    auto next = Tetromino::ShapeType(shapes(generator));
+
+    Placement placements[MAX_PLACEMENTS];
+    int played = 0;
+    for(; played < DATASET_MAX_SHAPES; ++played){
+        int count = board.placements(shape, placements);
+        if(count == 0){
+            // the last placement ended the game, it is still in this block
+            if(played > 0){
+                TrainingSample& last = block->raw[block->samples - 1];
+                last.outcome = uint8_t((last.outcome & 31) | SAMPLE_TOPPED_OUT << 5);
+            }
+            break;
+        }
+
+        Placement chosen;
+        if(_policy == DATASET_BOT){
+            chosen = bot.search(board, shape, next);
+        } else {
+            chosen = placements[std::uniform_int_distribution<>(0, count - 1)(generator)];
+        }
+
+        // only hand a block over when another sample needs the room,
+        // so the game's last sample can still be marked as topped out
+        if(block->samples == DATASET_BLOCK_SAMPLES){
+            _writer.submit(block);
+            block = _writer.takeBlock();
+        }
+
+        SearchBoard before = board;
+        int lines = board.place(shapeMask(shape, chosen.rotation), chosen.column, chosen.row);
+        packSample(before, shape, next, chosen, lines, block->raw[block->samples++]);
+
+        shape = next;
+        next = Tetromino::ShapeType(shapes(generator));
+    }
+
+    _samples += uint64_t(played);
+} // playGame
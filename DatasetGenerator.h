@@ -0,0 +1,52 @@
+// File: DatasetGenerator.h
+//   By: John Holik
+// Desc: Plays games headless on a WorkStealingPool and streams every
+//       placement to a DatasetWriter as a training sample. Shapes are
+//       placed by the bot or at random. Games are played on bare
+//       SearchBoards one placement at a time rather than frame by frame,
+//       so a sample costs one placement search.
+
+#ifndef TETRIS3_DATASETGENERATOR_H
+#define TETRIS3_DATASETGENERATOR_H
+#include "tetris.h"
+#include "TrainingData.h"
+#include "WorkStealingPool.h"
+#include <atomic>
+#include <cstdint>
+
+const int DATASET_MAX_SHAPES = 2000;    // a game stops after this many shapes
+const int DATASET_SEARCH_DEPTH = 2;     // bot search depth, repeatable below 3
+
+enum DatasetPolicy{
+    DATASET_BOT,     // placements chosen by TetrisBot
+    DATASET_RANDOM   // any placement of the shape
+};
+
+
+class DatasetGenerator {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    DatasetGenerator(WorkStealingPool& pool, DatasetWriter& writer,
+                     DatasetPolicy policy, uint32_t seed);
+
+    // Accessors
+    // --------------------------------------------------------
+    uint64_t getSamples() {return _samples;}
+
+    // Methods
+    // --------------------------------------------------------
+    void playGames(int games);
+
+private:
+    WorkStealingPool& _pool;
+    DatasetWriter& _writer;
+    DatasetPolicy _policy;
+    uint32_t _seed;
+    std::atomic<uint64_t> _samples;
+
+    void playGame(uint32_t seed, SampleBlock*& block);
+};
+
+
+#endif //TETRIS3_DATASETGENERATOR_H
@@ -0,0 +1,487 @@
+// File: DeltaStream.cpp
+//   By: John Holik
+// Desc: Implementation of the delta encoder and decoder
+
+#include "DeltaStream.h"
+#include "Collision.h"
+#include "PieceSet.h"
+#include <cstring>
+
+const int DELTA_ARG_BITS = 5;
+const int DELTA_ARG_MASK = (1 << DELTA_ARG_BITS) - 1;
+// shape, next, rotation, column, row, gameOver, pendingGarbage,
+// garbageHole, the two frame counters, linesCleared, seed, shapesGenerated
+const int KEYFRAME_HEADER = 8 + 2 * 2 + 3 * 4;
+const int KEYFRAME_ROW_BYTES = (GAME_COLUMNS * CELL_BITS + 7) / 8;
+
+// local functions
+static void writeOp(std::string& out, DeltaOp op, int arg);
+static void writeInt(std::string& out, uint32_t value, int bytes);
+static uint32_t readInt(const char* data, size_t& used, int bytes);
+static void writeKeyframe(std::string& out, const BoardState& state);
+static void lockShape(BoardState& state);
+static int clearLines(BoardState& state);
+static void insertGarbage(BoardState& state, int rows, int hole);
+static bool sameGrid(const BoardState& lhs, const BoardState& rhs);
+static bool sameBoard(const BoardState& lhs, const BoardState& rhs);
+static int findGarbage(const BoardState& locked, const BoardState& state, int& hole);
+
+
+// Encoder
+// ------------------------------------------------------------
+
+/**
+ * Default constructor, the first frame is a keyframe
+ */
+DeltaEncoder::DeltaEncoder() : _state{}, _hasState{false} { }
+
+/**
+ * Append one frame describing the change from the last frame
+ * @param state - board this frame
+ * @param out - stream to append to
+ */
+void DeltaEncoder::encode(const BoardState& state, std::string& out) {
+    size_t start = out.size();
+
+    if(!_hasState || !encodeDeltas(state, out)){
+        // deltas can't explain the change, send the whole board
+        out.resize(start);
+        writeKeyframe(out, state);
+        _state = state;
+        _hasState = true;
+    }
+
+    writeOp(out, DELTA_END, 0);
+} // encode
+
+/**
+ * Send a keyframe next frame, e.g. for a spectator that just joined
+ */
+void DeltaEncoder::reset() {
+    _hasState = false;
+} // reset
+
+/**
+ * Write the deltas from the last frame and check they rebuild the board
+ * @param state - board this frame
+ * @param out - stream to append to
+ * @return false if the deltas don't match, nothing is kept in that case
+ */
+bool DeltaEncoder::encodeDeltas(const BoardState& state, std::string& out) {
+    BoardState model = _state;
+
+    // the current shape is gone or the grid changed, so it locked
+    bool locked = model.shape != Tetromino::SHAPE_NONE &&
+                  (state.shape == Tetromino::SHAPE_NONE || !sameGrid(model, state));
+
+    if(locked){
+        // it locks where the board left its cell, try the last known
+        // rotation first since that is by far the most likely
+        bool found = false;
+        for(int turn = 0; turn < 4 && !found; ++turn){
+            int rotation = (model.rotation + turn) % 4;
+
+            BoardState trial = model;
+            trial.rotation = rotation;
+            trial.column = state.column;
+            trial.row = state.row;
+
+            lockShape(trial);
+            trial.linesCleared += clearLines(trial);
+
+            int hole = 0;
+            int garbage = findGarbage(trial, state, hole);
+            if(garbage >= 0){
+                if(rotation != model.rotation){
+                    writeOp(out, DELTA_ROTATE, rotation);
+                }
+                if(state.column != model.column){
+                    writeOp(out, DELTA_SHIFT, state.column - model.column);
+                }
+                if(state.row != model.row){
+                    writeOp(out, DELTA_DROP, model.row - state.row);
+                }
+                writeOp(out, DELTA_LOCK, 0);
+
+                if(garbage > 0){
+                    writeOp(out, DELTA_GARBAGE, garbage);
+                    out.push_back(char(hole));
+                    insertGarbage(trial, garbage, hole);
+                }
+                model = trial;
+                found = true;
+            }
+        } // each rotation
+
+        if(!found){
+            return false;
+        }
+    }
+
+    // a new shape appeared at the starting cell
+    if(model.shape == Tetromino::SHAPE_NONE && state.shape != Tetromino::SHAPE_NONE){
+        writeOp(out, DELTA_SPAWN, 0);
+        out.push_back(char(state.shape));
+        out.push_back(char(state.nextShape));
+
+        model.shape = state.shape;
+        model.nextShape = state.nextShape;
+        model.rotation = 0;
+        model.column = START_CELL_COLUMN;
+        model.row = START_CELL_ROW;
+        ++model.shapesGenerated;
+    }
+
+    if(model.shape != Tetromino::SHAPE_NONE){
+        if(state.rotation != model.rotation){
+            writeOp(out, DELTA_ROTATE, state.rotation);
+            model.rotation = state.rotation;
+        }
+        if(state.column != model.column){
+            writeOp(out, DELTA_SHIFT, state.column - model.column);
+            model.column = state.column;
+        }
+        if(state.row < model.row){
+            writeOp(out, DELTA_DROP, model.row - state.row);
+            model.row = state.row;
+        }
+    }
+
+    if(!sameBoard(model, state)){
+        return false;
+    }
+
+    _state = model;
+    return true;
+} // encodeDeltas
+
+
+// Decoder
+// ------------------------------------------------------------
+
+/**
+ * Default constructor starts with an empty board
+ */
+DeltaDecoder::DeltaDecoder() : _state{} {
+    _state.shape = Tetromino::SHAPE_NONE;
+    _state.nextShape = Tetromino::SHAPE_NONE;
+}
+
+/**
+ * Apply one frame from the stream
+ * @param data - stream bytes
+ * @param size - bytes available
+ * @return bytes used by the frame, 0 if the frame is not complete yet
+ */
+size_t DeltaDecoder::decode(const char* data, size_t size) {
+    BoardState state = _state;
+    size_t used = 0;
+
+    while(used < size){
+        auto header = static_cast<unsigned char>(data[used++]);
+        auto op = DeltaOp(header >> DELTA_ARG_BITS);
+        int arg = header & DELTA_ARG_MASK;
+
+        switch(op){
+            case DELTA_END:
+                _state = state;
+                return used;
+
+            case DELTA_SHIFT:
+                // sign extend the argument
+                state.column += arg >= (1 << (DELTA_ARG_BITS - 1)) ? arg - (1 << DELTA_ARG_BITS) : arg;
+                break;
+
+            case DELTA_DROP:
+                state.row -= arg;
+                break;
+
+            case DELTA_ROTATE:
+                state.rotation = arg;
+                break;
+
+            case DELTA_LOCK:
+                lockShape(state);
+                state.linesCleared += clearLines(state);
+                break;
+
+            case DELTA_GARBAGE:
+                if(used + 1 > size){
+                    return 0;
+                }
+                insertGarbage(state, arg, data[used++]);
+                break;
+
+            case DELTA_SPAWN:
+                if(used + 2 > size){
+                    return 0;
+                }
+                state.shape = data[used++];
+                state.nextShape = data[used++];
+                state.rotation = 0;
+                state.column = START_CELL_COLUMN;
+                state.row = START_CELL_ROW;
+                ++state.shapesGenerated;
+                break;
+
+            case DELTA_KEYFRAME: {
+                size_t rowMaskBytes = (GAME_ROWS + 7) / 8;
+                if(used + KEYFRAME_HEADER + rowMaskBytes > size){
+                    return 0;
+                }
+                state.shape = data[used++];
+                state.nextShape = data[used++];
+                state.rotation = data[used++];
+                state.column = data[used++];
+                state.row = data[used++];
+                state.gameOver = data[used++];
+                state.pendingGarbage = data[used++];
+                state.garbageHole = data[used++];
+                state.newShapeFrame = int16_t(readInt(data, used, 2));
+                state.autoMoveFrame = int16_t(readInt(data, used, 2));
+                state.linesCleared = int32_t(readInt(data, used, 4));
+                state.seed = readInt(data, used, 4);
+                state.shapesGenerated = readInt(data, used, 4);
+
+                uint32_t filledRows = 0;
+                for(size_t byte = 0; byte < rowMaskBytes; ++byte){
+                    filledRows |= uint32_t(static_cast<unsigned char>(data[used++])) << (byte * 8);
+                }
+
+                for(int row = 0; row < GAME_ROWS; ++row){
+                    state.cells[row] = 0;
+                    if((filledRows >> row) & 1u){
+                        if(used + KEYFRAME_ROW_BYTES > size){
+                            return 0;
+                        }
+                        for(int byte = 0; byte < KEYFRAME_ROW_BYTES; ++byte){
+                            state.cells[row] |= uint64_t(static_cast<unsigned char>(data[used++])) << (byte * 8);
+                        }
+                    }
+                } // each row
+                break;
+            }
+        } // op
+    } // each op
+
+    return 0; // no end of frame yet
+} // decode
+
+/**
+ * Rebuild a board from the decoded state
+ * @param board - board to update
+ */
+void DeltaDecoder::apply(TetrisBoard& board) {
+    board.setState(_state);
+} // apply
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * @param out - stream to append to
+ * @param op - operation
+ * @param arg - argument kept in the low bits of the op byte
+ */
+static void writeOp(std::string& out, DeltaOp op, int arg) {
+    out.push_back(char((op << DELTA_ARG_BITS) | (arg & DELTA_ARG_MASK)));
+}
+
+/**
+ * @param out - stream to append to
+ * @param value - value to write, low byte first
+ * @param bytes - bytes of it to write
+ */
+static void writeInt(std::string& out, uint32_t value, int bytes) {
+    for(int byte = 0; byte < bytes; ++byte){
+        out.push_back(char(value >> (byte * 8)));
+    }
+}
+
+/**
+ * @param data - stream bytes
+ * @param used - position to read at, moved past the value
+ * @param bytes - bytes in the value, low byte first
+ * @return value read
+ */
+static uint32_t readInt(const char* data, size_t& used, int bytes) {
+    uint32_t value = 0;
+    for(int byte = 0; byte < bytes; ++byte){
+        value |= uint32_t(static_cast<unsigned char>(data[used++])) << (byte * 8);
+    }
+    return value;
+}
+
+/**
+ * Write the whole BoardState, only rows with filled cells are included
+ * @param out - stream to append to
+ * @param state - board to write
+ */
+static void writeKeyframe(std::string& out, const BoardState& state) {
+    writeOp(out, DELTA_KEYFRAME, 0);
+    out.push_back(char(state.shape));
+    out.push_back(char(state.nextShape));
+    out.push_back(char(state.rotation));
+    out.push_back(char(state.column));
+    out.push_back(char(state.row));
+    out.push_back(char(state.gameOver));
+    out.push_back(char(state.pendingGarbage));
+    out.push_back(char(state.garbageHole));
+    writeInt(out, uint16_t(state.newShapeFrame), 2);
+    writeInt(out, uint16_t(state.autoMoveFrame), 2);
+    writeInt(out, uint32_t(state.linesCleared), 4);
+    writeInt(out, state.seed, 4);
+    writeInt(out, state.shapesGenerated, 4);
+
+    uint32_t filledRows = 0;
+    for(int row = 0; row < GAME_ROWS; ++row){
+        if(state.cells[row] != 0){
+            filledRows |= 1u << row;
+        }
+    }
+    for(int byte = 0; byte < (GAME_ROWS + 7) / 8; ++byte){
+        out.push_back(char(filledRows >> (byte * 8)));
+    }
+
+    for(int row = 0; row < GAME_ROWS; ++row){
+        if(state.cells[row] != 0){
+            for(int byte = 0; byte < KEYFRAME_ROW_BYTES; ++byte){
+                out.push_back(char(state.cells[row] >> (byte * 8)));
+            }
+        }
+    }
+}
+
+/**
+ * Lock the current shape into the grid, the same as TetrisBoard::lockShape()
+ * @param state - board to update, the shape is removed
+ */
+static void lockShape(BoardState& state) {
+    const ShapeMask& mask = shapeMask(Tetromino::ShapeType(state.shape), state.rotation);
+    int color = pieceSet().getPiece(state.shape).color;
+
+    for(int row = 0; row < mask.rows; ++row){
+        for(int column = 0; column < mask.columns; ++column){
+            int gridRow = state.row - row;
+            int gridColumn = state.column + column;
+
+            if(((mask.bits[row] >> column) & 1u) &&
+               gridRow >= 0 && gridRow < GAME_ROWS &&
+               gridColumn >= 0 && gridColumn < GAME_COLUMNS){
+                state.cells[gridRow] |= uint64_t(color) << (gridColumn * CELL_BITS);
+            }
+        }
+    }
+
+    state.shape = Tetromino::SHAPE_NONE;
+    state.rotation = 0;
+}
+
+/**
+ * Remove full rows, the same as TetrisBoard::clearLines()
+ * @param state - board to update
+ * @return number of rows removed
+ */
+static int clearLines(BoardState& state) {
+    int cleared = 0;
+
+    for(int row = 0; row < GAME_ROWS; ++row){
+        bool full = true;
+        for(int column = 0; column < GAME_COLUMNS && full; ++column){
+            full = cellAt(state, row, column) != CELL_EMPTY;
+        }
+
+        if(full){
+            ++cleared;
+        } else if(cleared > 0){
+            state.cells[row - cleared] = state.cells[row];
+        }
+    }
+
+    for(int row = GAME_ROWS - cleared; row < GAME_ROWS; ++row){
+        state.cells[row] = 0;
+    }
+    return cleared;
+}
+
+/**
+ * Push garbage rows in from the bottom, the same as TetrisBoard::insertGarbage()
+ * @param state - board to update, nothing is left pending
+ * @param rows - number of garbage rows
+ * @param hole - open column of each garbage row
+ */
+static void insertGarbage(BoardState& state, int rows, int hole) {
+    state.pendingGarbage = 0;
+    state.garbageHole = int8_t(hole);
+
+    for(int row = GAME_ROWS - 1; row >= rows; --row){
+        state.cells[row] = state.cells[row - rows];
+    }
+
+    for(int row = 0; row < rows && row < GAME_ROWS; ++row){
+        state.cells[row] = 0;
+        for(int column = 0; column < GAME_COLUMNS; ++column){
+            if(column != hole){
+                state.cells[row] |= uint64_t(CELL_GARBAGE) << (column * CELL_BITS);
+            }
+        }
+    }
+}
+
+/**
+ * @return true if both boards have the same grid
+ */
+static bool sameGrid(const BoardState& lhs, const BoardState& rhs) {
+    return std::memcmp(lhs.cells, rhs.cells, sizeof(lhs.cells)) == 0;
+}
+
+/**
+ * @return true if both boards have the same grid, shapes, garbage and
+ *         progress, the rotation and cell only count while there is a
+ *         current shape and the frame counters not at all
+ */
+static bool sameBoard(const BoardState& lhs, const BoardState& rhs) {
+    bool same = sameGrid(lhs, rhs) &&
+                lhs.shape == rhs.shape &&
+                lhs.nextShape == rhs.nextShape &&
+                lhs.gameOver == rhs.gameOver &&
+                lhs.pendingGarbage == rhs.pendingGarbage &&
+                lhs.garbageHole == rhs.garbageHole &&
+                lhs.linesCleared == rhs.linesCleared &&
+                lhs.seed == rhs.seed &&
+                lhs.shapesGenerated == rhs.shapesGenerated;
+
+    if(same && lhs.shape != Tetromino::SHAPE_NONE){
+        same = lhs.rotation == rhs.rotation &&
+               lhs.column == rhs.column &&
+               lhs.row == rhs.row;
+    }
+    return same;
+}
+
+/**
+ * Find how many garbage rows turn the locked board into the new board
+ * @param locked - board after the lock and line clears
+ * @param state - board this frame
+ * @param hole - receives the open column of the garbage
+ * @return number of garbage rows, -1 if no amount matches
+ */
+static int findGarbage(const BoardState& locked, const BoardState& state, int& hole) {
+    for(int rows = 0; rows < GAME_ROWS; ++rows){
+        hole = 0;
+        if(rows > 0){
+            // the bottom row says where the hole is
+            while(hole < GAME_COLUMNS && cellAt(state, 0, hole) != CELL_EMPTY){
+                ++hole;
+            }
+        }
+
+        BoardState trial = locked;
+        insertGarbage(trial, rows, hole);
+        if(sameGrid(trial, state)){
+            return rows;
+        }
+    }
+    return -1;
+}
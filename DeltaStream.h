@@ -0,0 +1,75 @@
+// File: DeltaStream.h
+//   By: John Holik
+// Desc: Delta encoding of a board for spectators. Instead of a full
+//       BoardState each frame, the encoder writes what happened since
+//       the last frame: the shape spawned, the moves applied, the shape
+//       locking (with any cleared lines) and garbage arriving. A frame
+//       where nothing happened is a single byte. Anything the deltas
+//       cannot explain is sent as a keyframe with the full BoardState.
+//       The deltas keep the lines cleared and the shape generator in
+//       step too, only the frame counters are exact just on keyframes,
+//       a spectator shows the board but doesn't play on from it.
+
+#ifndef TETRIS3_DELTASTREAM_H
+#define TETRIS3_DELTASTREAM_H
+#include "BoardState.h"
+#include "TetrisBoard.h"
+#include <string>
+#include <cstddef>
+
+// each operation starts with a byte holding the op in the high bits
+// and a small argument in the low bits
+enum DeltaOp{
+    DELTA_END = 0,      // end of frame
+    DELTA_SHIFT = 1,    // arg: columns moved (signed)
+    DELTA_DROP = 2,     // arg: rows moved down
+    DELTA_ROTATE = 3,   // arg: new rotation
+    DELTA_LOCK = 4,     // shape locked in place, full lines cleared
+    DELTA_GARBAGE = 5,  // arg: rows, next byte: hole column
+    DELTA_SPAWN = 6,    // next bytes: shape, next shape
+    DELTA_KEYFRAME = 7  // full BoardState follows
+};
+
+
+class DeltaEncoder {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    DeltaEncoder();
+
+    // Methods
+    // --------------------------------------------------------
+    void encode(const BoardState& state, std::string& out);
+
+    void reset(); // next frame is a keyframe
+
+private:
+    BoardState _state;  // board as the decoder will have it
+    bool _hasState;
+
+    bool encodeDeltas(const BoardState& state, std::string& out);
+};
+
+
+class DeltaDecoder {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    DeltaDecoder();
+
+    // Accessors
+    // --------------------------------------------------------
+    const BoardState& getState() {return _state;}
+
+    // Methods
+    // --------------------------------------------------------
+    size_t decode(const char* data, size_t size);
+
+    void apply(TetrisBoard& board);
+
+private:
+    BoardState _state;
+};
+
+
+#endif //TETRIS3_DELTASTREAM_H
@@ -0,0 +1,80 @@
+// File: GameInput.cpp
+//   By: John Holik
+// Desc: Conversion of input bits to key states
+
+#include "GameInput.h"
+
+// keys matching each bit of InputBits
+const sf::Keyboard::Key INPUT_KEYS[] = {sf::Keyboard::Key::Space, sf::Keyboard::Key::A,
+                                        sf::Keyboard::Key::D, sf::Keyboard::Key::S};
+
+/**
+ * Press game keys the same way processEvents() does for a key released
+ * on the keyboard, so the board sees them on its next Update()
+ * @param bits - InputBits of the keys to press
+ * @param input - key states passed to TetrisBoard::Update()
+ */
+void pressInputs(unsigned int bits, KeyPressedState input[]){
+    for(int key = 0; key < 4; ++key){
+        if((bits >> key) & 1u){
+            // only a key that was not already pressed is picked up
+            if(!input[INPUT_KEYS[key]].prior){
+                input[INPUT_KEYS[key]].current = true;
+                input[INPUT_KEYS[key]].prior = true;
+            }
+        }
+    }
+} // pressInputs
+
+/**
+ * Press exactly the given keys for the next Update() and release the
+ * others. Unlike pressInputs() a key held down acts every frame instead
+ * of every other frame.
+ * @param bits - InputBits of the keys to press
+ * @param input - key states passed to TetrisBoard::Update()
+ */
+void setInputs(unsigned int bits, KeyPressedState input[]){
+    for(int key = 0; key < 4; ++key){
+        bool pressed = (bits >> key) & 1u;
+        input[INPUT_KEYS[key]] = {pressed, pressed};
+    }
+} // setInputs
+
+/**
+ * @param key - keyboard key
+ * @return InputBits of the game key, INPUT_NONE if it isn't one
+ */
+unsigned int keyInput(sf::Keyboard::Key key){
+    for(int bit = 0; bit < 4; ++bit){
+        if(INPUT_KEYS[bit] == key){
+            return 1u << bit;
+        }
+    }
+    return INPUT_NONE;
+} // keyInput
+
+/**
+ * Pack the state of the game keys, enough to repeat an Update() exactly
+ * @param input - key states
+ * @return prior flags in bits 0-3 and current flags in bits 4-7
+ */
+unsigned int packKeys(const KeyPressedState input[]){
+    unsigned int keys = 0;
+    for(int key = 0; key < 4; ++key){
+        keys |= (input[INPUT_KEYS[key]].prior ? 1u : 0u) << key;
+        keys |= (input[INPUT_KEYS[key]].current ? 1u : 0u) << (key + 4);
+    }
+    return keys;
+} // packKeys
+
+/**
+ * Restore the game keys packed by packKeys()
+ * @param keys - packed key states
+ * @param input - key states to update
+ */
+void unpackKeys(unsigned int keys, KeyPressedState input[]){
+    for(int key = 0; key < 4; ++key){
+        input[INPUT_KEYS[key]].prior = (keys >> key) & 1u;
+        input[INPUT_KEYS[key]].current = (keys >> (key + 4)) & 1u;
+    }
+} // unpackKeys
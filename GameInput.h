@@ -0,0 +1,29 @@
+// File: GameInput.h
+//   By: John Holik
+// Desc: The game keys packed into a few bits so input can be sent,
+//       recorded or generated without a keyboard
+
+#ifndef TETRIS3_GAMEINPUT_H
+#define TETRIS3_GAMEINPUT_H
+#include "tetris.h"
+#include <SFML/Graphics.hpp>
+
+// one bit per game key
+enum InputBits{
+    INPUT_NONE = 0,
+    INPUT_ROTATE = 1,   // Space
+    INPUT_LEFT = 2,     // A
+    INPUT_RIGHT = 4,    // D
+    INPUT_DOWN = 8,     // S
+    INPUT_ALL = 15
+};
+
+void pressInputs(unsigned int bits, KeyPressedState input[]);
+void setInputs(unsigned int bits, KeyPressedState input[]);
+unsigned int keyInput(sf::Keyboard::Key key);
+
+// the prior (low 4 bits) and current (high 4 bits) state of the game keys
+unsigned int packKeys(const KeyPressedState input[]);
+void unpackKeys(unsigned int keys, KeyPressedState input[]);
+
+#endif //TETRIS3_GAMEINPUT_H
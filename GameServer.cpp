@@ -0,0 +1,368 @@
+// File: GameServer.cpp
+//   By: John Holik
+// Desc: Implementation of the headless game server (Linux epoll)
+
+#include "GameServer.h"
+#include "GameInput.h"
+#include "PieceSet.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+const int SERVER_MAX_EVENTS = 256;     // epoll events handled per wait
+const int SERVER_MAX_CATCHUP = 4;      // ticks run at once after a stall
+const int SERVER_REPORT_TICKS = FPS * 10; // how often to print stats
+
+/**
+ * Property constructor, nothing is opened until run()
+ * @param port - TCP port on 127.0.0.1 to listen on, 0 for none
+ * @param socketPath - UNIX socket to listen on, empty for none
+ * @param workers - number of simulation threads
+ * @param deltaStream - send each client a delta stream of its board
+ *                      instead of a StateMessage every tick
+ */
+GameServer::GameServer(int port, const std::string& socketPath, int workers, bool deltaStream)
+        : _port{port}, _socketPath{socketPath}, _deltaStream{deltaStream},
+          _epoll{-1}, _tcpListener{-1}, _unixListener{-1}, _timer{-1},
+          _stopping{false}, _tick{0},
+          _workerCount{workers > 0 ? workers : 1},
+          _startTick{_workerCount + 1}, _endTick{_workerCount + 1},
+          _shuttingDown{false} {
+
+    for(int worker = 0; worker < _workerCount; ++worker){
+        _workers.emplace_back(&GameServer::workerLoop, this, worker);
+    }
+} // property
+
+/**
+ * Destructor closes every session and socket and stops the workers
+ */
+GameServer::~GameServer() {
+    _shuttingDown = true;
+    _startTick.wait(); // release the workers so they see the flag
+
+    for(std::thread& worker : _workers){
+        worker.join();
+    }
+
+    while(!_sessions.empty()){
+        closeSession(_sessions.back());
+    }
+
+    for(int fd : {_tcpListener, _unixListener, _timer, _epoll}){
+        if(fd >= 0){
+            close(fd);
+        }
+    }
+    if(!_socketPath.empty()){
+        unlink(_socketPath.c_str());
+    }
+} // destructor
+
+/**
+ * Serve clients until stop() is called
+ * @return false if the server could not start
+ */
+bool GameServer::run() {
+    if(!listen()){
+        return false;
+    }
+
+    epoll_event events[SERVER_MAX_EVENTS];
+    auto reportStart = std::chrono::steady_clock::now();
+
+    while(!_stopping){
+        int count = epoll_wait(_epoll, events, SERVER_MAX_EVENTS, FRAME_RATE_MS * 4);
+
+        for(int index = 0; index < count; ++index){
+            int fd = events[index].data.fd;
+
+            if(fd == _tcpListener || fd == _unixListener){
+                accept(fd);
+            }
+            else if(fd == _timer){
+                uint64_t expired = 0;
+                if(read(_timer, &expired, sizeof(expired)) == sizeof(expired)){
+                    for(uint64_t tick = 0; tick < expired && tick < SERVER_MAX_CATCHUP; ++tick){
+                        runTick();
+                    }
+                }
+
+                if(_tick % SERVER_REPORT_TICKS == 0){
+                    auto now = std::chrono::steady_clock::now();
+                    double seconds = std::chrono::duration<double>(now - reportStart).count();
+                    std::cout << "tick " << _tick << ": " << _sessions.size() << " sessions, "
+                              << SERVER_REPORT_TICKS / seconds << " ticks/s" << std::endl;
+                    reportStart = now;
+                }
+            }
+            else {
+                auto found = _bySocket.find(fd);
+                if(found == _bySocket.end()){
+                    continue; // closed earlier in this batch
+                }
+
+                Session* session = found->second;
+                if(events[index].events & (EPOLLHUP | EPOLLERR)){
+                    closeSession(session);
+                    continue;
+                }
+                // a failed write closes the session, don't read from it
+                if((events[index].events & EPOLLOUT) && !flush(session)){
+                    continue;
+                }
+                if(events[index].events & EPOLLIN){
+                    readInput(session);
+                }
+            }
+        } // each event
+    } // until stopped
+
+    return true;
+} // run
+
+/**
+ * Ask run() to return, safe to call from a signal handler
+ */
+void GameServer::stop() {
+    _stopping = true;
+} // stop
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * Open the listening sockets, tick timer and epoll instance
+ * @return false if any of them failed
+ */
+bool GameServer::listen() {
+    _epoll = epoll_create1(0);
+    if(_epoll < 0){
+        std::cerr << "epoll_create1: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+
+    if(_port > 0){
+        _tcpListener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int reuse = 1;
+        setsockopt(_tcpListener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(uint16_t(_port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if(bind(_tcpListener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+           ::listen(_tcpListener, SOMAXCONN) < 0){
+            std::cerr << "tcp port " << _port << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        event.data.fd = _tcpListener;
+        epoll_ctl(_epoll, EPOLL_CTL_ADD, _tcpListener, &event);
+    }
+
+    if(!_socketPath.empty()){
+        _unixListener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, _socketPath.c_str(), sizeof(address.sun_path) - 1);
+        unlink(_socketPath.c_str()); // left over from an earlier run
+
+        if(bind(_unixListener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+           ::listen(_unixListener, SOMAXCONN) < 0){
+            std::cerr << _socketPath << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        event.data.fd = _unixListener;
+        epoll_ctl(_epoll, EPOLL_CTL_ADD, _unixListener, &event);
+    }
+
+    // update timer at the same rate as the windowed game
+    _timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    itimerspec interval{};
+    interval.it_interval.tv_nsec = long(FRAME_RATE_MS) * 1000000L;
+    interval.it_value = interval.it_interval;
+    timerfd_settime(_timer, 0, &interval, nullptr);
+
+    event.data.fd = _timer;
+    epoll_ctl(_epoll, EPOLL_CTL_ADD, _timer, &event);
+
+    return true;
+} // listen
+
+/**
+ * Accept every pending connection and give each a new game
+ * @param listener - listening socket that is ready
+ */
+void GameServer::accept(int listener) {
+    int client;
+    while((client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK)) >= 0){
+        if(listener == _tcpListener){
+            int noDelay = 1;
+            setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        }
+
+        Session* session = new Session{client, new TetrisBoard(),
+                                       std::vector<KeyPressedState>(sf::Keyboard::KeyCount, KeyPressedState{false, false}),
+                                       INPUT_NONE, false, std::string(), false, DeltaEncoder()};
+        _sessions.push_back(session);
+        _bySocket[client] = session;
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = client;
+        epoll_ctl(_epoll, EPOLL_CTL_ADD, client, &event);
+    }
+} // accept
+
+/**
+ * Collect input bytes from a client, every byte holds InputBits
+ * @param session - client with data to read
+ * @return false if the client went away and the session was closed
+ */
+bool GameServer::readInput(Session* session) {
+    unsigned char buffer[256];
+    ssize_t bytes;
+
+    while((bytes = read(session->socket, buffer, sizeof(buffer))) > 0){
+        for(ssize_t index = 0; index < bytes; ++index){
+            session->pendingInput |= buffer[index] & INPUT_ALL;
+        }
+    }
+
+    if(bytes == 0 || (bytes < 0 && errno != EAGAIN && errno != EWOULDBLOCK)){
+        closeSession(session); // client went away
+        return false;
+    }
+    return true;
+} // readInput
+
+/**
+ * Write as much queued output as the socket takes, and wait for
+ * EPOLLOUT while anything is left
+ * @param session - client to write to
+ * @return false if the write failed and the session was closed
+ */
+bool GameServer::flush(Session* session) {
+    while(!session->output.empty()){
+        ssize_t bytes = send(session->socket, session->output.data(), session->output.size(), MSG_NOSIGNAL);
+        if(bytes <= 0){
+            if(bytes < 0 && errno != EAGAIN && errno != EWOULDBLOCK){
+                closeSession(session);
+                return false;
+            }
+            break; // socket is full
+        }
+        session->output.erase(0, size_t(bytes));
+    }
+
+    bool waiting = !session->output.empty();
+    if(waiting != session->waitingToWrite){
+        epoll_event event{};
+        event.events = EPOLLIN | (waiting ? uint32_t(EPOLLOUT) : 0u);
+        event.data.fd = session->socket;
+        epoll_ctl(_epoll, EPOLL_CTL_MOD, session->socket, &event);
+        session->waitingToWrite = waiting;
+    }
+    return true;
+} // flush
+
+/**
+ * Close a client socket and end its game
+ * @param session - client to remove
+ */
+void GameServer::closeSession(Session* session) {
+    epoll_ctl(_epoll, EPOLL_CTL_DEL, session->socket, nullptr);
+    close(session->socket);
+    _bySocket.erase(session->socket);
+
+    // swap with the last session so the vector stays packed
+    for(size_t index = 0; index < _sessions.size(); ++index){
+        if(_sessions[index] == session){
+            _sessions[index] = _sessions.back();
+            _sessions.pop_back();
+            break;
+        }
+    }
+
+    delete session->board;
+    delete session;
+} // closeSession
+
+/**
+ * Update every session once and send each client its new state
+ */
+void GameServer::runTick() {
+    ++_tick;
+
+    _startTick.wait(); // workers update their shards
+    _endTick.wait();   // every session is done
+
+    // flushing can close sessions, so walk a copy
+    std::vector<Session*> sessions = _sessions;
+    for(Session* session : sessions){
+        flush(session);
+    }
+} // runTick
+
+/**
+ * Update the sessions assigned to a worker once per tick
+ * @param worker - index of the worker, sessions are dealt out round robin
+ */
+void GameServer::workerLoop(int worker) {
+    StateMessage message{};
+    message.pieceSet = pieceSet().hash(); // the set doesn't change while serving
+
+    while(true){
+        _startTick.wait();
+        if(_shuttingDown){
+            break;
+        }
+
+        for(size_t index = worker; index < _sessions.size(); index += _workerCount){
+            Session* session = _sessions[index];
+
+            if(!session->finished){
+                pressInputs(session->pendingInput, session->input.data());
+                session->pendingInput = INPUT_NONE;
+                session->finished = session->board->Update(session->input.data());
+            }
+
+            message.tick = _tick;
+            session->board->getState(message.state);
+
+            if(_deltaStream){
+                // a client that is not reading misses frames, the next
+                // frame sent covers them, as a keyframe if it has to
+                if(session->output.size() < SERVER_MAX_BACKLOG * sizeof(StateMessage)){
+                    session->encoder.encode(message.state, session->output);
+                }
+                continue;
+            }
+
+            // a client that is not reading gets only the latest states,
+            // the rest of a partly written message is kept
+            if(session->output.size() >= SERVER_MAX_BACKLOG * sizeof(StateMessage)){
+                session->output.resize(session->output.size() % sizeof(StateMessage));
+            }
+            session->output.append(reinterpret_cast<const char*>(&message), sizeof(message));
+        }
+
+        _endTick.wait();
+    }
+} // workerLoop
@@ -0,0 +1,97 @@
+// File: GameServer.h
+//   By: John Holik
+// Desc: Headless game server. Each client connection gets its own
+//       TetrisBoard. Clients send InputBits bytes and receive a
+//       StateMessage after every update tick, or with deltaStream set,
+//       one DeltaEncoder frame per tick, which is what a spectator
+//       watching many boards wants. One epoll loop handles every socket
+//       and a timer, the board updates are sharded across a pool of
+//       worker threads.
+
+#ifndef TETRIS3_GAMESERVER_H
+#define TETRIS3_GAMESERVER_H
+#include "tetris.h"
+#include "TetrisBoard.h"
+#include "BoardState.h"
+#include "DeltaStream.h"
+#include "TickBarrier.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// sent to the client after each tick, fixed size so no framing is needed
+struct StateMessage{
+    uint32_t tick;      // server tick the state belongs to
+    uint32_t pieceSet;  // PieceSet::hash() of the server's set, a client
+                        // with another set can't follow the state
+    BoardState state;
+};
+
+const int SERVER_MAX_BACKLOG = 64; // queued messages before a slow client skips ahead
+
+
+class GameServer {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    GameServer(int port, const std::string& socketPath, int workers, bool deltaStream = false);
+
+    ~GameServer(); // destructor
+
+    // Accessors
+    // --------------------------------------------------------
+    int getSessionCount() {return int(_sessions.size());}
+
+    // Methods
+    // --------------------------------------------------------
+    bool run();
+
+    void stop();
+
+private:
+    struct Session{
+        int socket;
+        TetrisBoard* board;
+        std::vector<KeyPressedState> input;
+        unsigned int pendingInput; // InputBits received since the last tick
+        bool finished;             // board reported the game is over
+        std::string output;        // bytes not written to the socket yet
+        bool waitingToWrite;       // registered for EPOLLOUT
+        DeltaEncoder encoder;      // board as the client has it, for the delta stream
+    };
+
+    int _port;                // TCP loopback port, 0 = none
+    std::string _socketPath;  // UNIX socket path, empty = none
+    bool _deltaStream;        // send DeltaEncoder frames instead of StateMessages
+
+    int _epoll;
+    int _tcpListener;
+    int _unixListener;
+    int _timer;               // fires once per update frame
+    std::atomic<bool> _stopping;
+
+    std::vector<Session*> _sessions;
+    std::unordered_map<int, Session*> _bySocket;
+    uint32_t _tick;
+
+    // workers update their shard of the sessions each tick
+    int _workerCount;
+    std::vector<std::thread> _workers;
+    TickBarrier _startTick;
+    TickBarrier _endTick;
+    bool _shuttingDown;
+
+    bool listen();
+    void accept(int listener);
+    bool readInput(Session* session);
+    bool flush(Session* session);
+    void closeSession(Session* session);
+    void runTick();
+    void workerLoop(int worker);
+};
+
+
+#endif //TETRIS3_GAMESERVER_H
@@ -0,0 +1,27 @@
+// File: Gravity.cpp
+//   By: John Holik
+// Desc: Gravity curve for each level
+
+#include "Gravity.h"
+#include <algorithm>
+
+
+/**
+ * Gravity follows the guideline curve, a level takes
+ * (0.8 - (level - 1) * 0.007) ^ (level - 1) seconds per row. The table
+ * holds it at FPS ticks per second so every machine gets exactly the
+ * same numbers, which lockstep and rollback games depend on.
+ * @param level - level, from 1
+ * @return gravity in rows per tick, GRAVITY_ONE is one row
+ */
+int32_t gravityForLevel(int level) {
+    static const int32_t GRAVITY_CURVE[GRAVITY_LEVELS] = {
+              1092,   1377,   1768,   2311,   3075,
+              4169,   5759,   8107,  11634,  17026,
+             25416,  38709,  60169,  95483, 154742,
+            256187, 433425, GRAVITY_MAX, GRAVITY_MAX, GRAVITY_MAX};
+    static_assert(FPS == 30, "GRAVITY_CURVE is worked out for 30 ticks per second");
+
+    level = std::max(1, std::min(level, GRAVITY_LEVELS));
+    return GRAVITY_CURVE[level - 1];
+} // gravityForLevel
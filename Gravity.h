@@ -0,0 +1,36 @@
+// File: Gravity.h
+//   By: John Holik
+// Desc: Level based gravity. Gravity is kept as a fixed point number of
+//       rows per tick and added up every tick, so a shape can fall a
+//       fraction of a row per tick at low levels and many rows per tick
+//       at high ones, up to 20G (20 rows every tick).
+
+#ifndef TETRIS3_GRAVITY_H
+#define TETRIS3_GRAVITY_H
+#include "tetris.h"
+#include <cstdint>
+
+// one row per tick, the fraction fits in FrameCounters::autoMove
+const int32_t GRAVITY_ONE = 1 << 15;
+
+// fastest gravity, 20 rows every tick
+const int32_t GRAVITY_MAX = 20 * GRAVITY_ONE;
+
+// levels with their own gravity, higher levels stay at the last one
+const int GRAVITY_LEVELS = 20;
+
+// lines to clear to go up a level
+const int LINES_PER_LEVEL = 10;
+
+int32_t gravityForLevel(int level);
+
+/**
+ * @param startLevel - level the game started at
+ * @param linesCleared - lines cleared so far
+ * @return current level
+ */
+inline int levelForLines(int startLevel, int linesCleared){
+    return startLevel + linesCleared / LINES_PER_LEVEL;
+}
+
+#endif //TETRIS3_GRAVITY_H
@@ -0,0 +1,64 @@
+// File: HeadlessRunner.cpp
+//   By: John Holik
+// Desc: Implementation of the headless game runner
+
+#include "HeadlessRunner.h"
+#include "GameInput.h"
+#include <chrono>
+#include <cstring>
+
+// local functions
+static uint64_t hashState(const BoardState& state);
+
+
+/**
+ * Play a board until the game ends or the tick limit
+ * @param board - board to play, from whatever state it is in
+ * @param input - keys for each tick
+ * @param maxTicks - most ticks to run
+ * @return how the game went
+ */
+HeadlessResult runHeadless(TetrisBoard& board, InputSource& input, uint32_t maxTicks) {
+    auto start = std::chrono::steady_clock::now();
+
+    KeyPressedState keys[sf::Keyboard::KeyCount] = {};
+    BoardState state{};
+
+    uint32_t tick = 0;
+    bool gameOver = board.isGameOver();
+    while(!gameOver && tick < maxTicks){
+        board.getState(state);
+        pressInputs(input.nextInput(state, tick), keys);
+        gameOver = board.Update(keys);
+        ++tick;
+    }
+
+    board.getState(state);
+    HeadlessResult result{};
+    result.ticks = tick;
+    result.lines = state.linesCleared;
+    result.shapes = state.shapesGenerated;
+    result.gameOver = gameOver;
+    result.stateHash = hashState(state);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+} // runHeadless
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * @param state - board to hash
+ * @return FNV-1a hash of its bytes
+ */
+static uint64_t hashState(const BoardState& state) {
+    unsigned char bytes[sizeof(BoardState)];
+    std::memcpy(bytes, &state, sizeof(bytes));
+
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for(unsigned char byte : bytes){
+        hash = (hash ^ byte) * 0x100000001B3ull;
+    }
+    return hash;
+}
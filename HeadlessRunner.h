@@ -0,0 +1,26 @@
+// File: HeadlessRunner.h
+//   By: John Holik
+// Desc: Plays a board without a window or clock. Each tick asks an
+//       InputSource for the keys and runs one Update(), as fast as the
+//       machine allows. Gravity and the spawn delay are counted in ticks
+//       (see TetrisBoard::setTiming), so a game plays exactly as it
+//       would in the window, only many times faster.
+
+#ifndef TETRIS3_HEADLESSRUNNER_H
+#define TETRIS3_HEADLESSRUNNER_H
+#include "TetrisBoard.h"
+#include "InputSource.h"
+#include <cstdint>
+
+struct HeadlessResult{
+    uint32_t ticks;       // ticks run
+    int lines;            // lines cleared
+    uint32_t shapes;      // shapes spawned
+    bool gameOver;        // false if it stopped at the tick limit
+    uint64_t stateHash;   // hash of the final BoardState, for regression checks
+    double seconds;       // time taken
+};
+
+HeadlessResult runHeadless(TetrisBoard& board, InputSource& input, uint32_t maxTicks);
+
+#endif //TETRIS3_HEADLESSRUNNER_H
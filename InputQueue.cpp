@@ -0,0 +1,157 @@
+// File: InputQueue.cpp
+//   By: John Holik
+// Desc: Implementation of the timestamped input queue
+
+#include "InputQueue.h"
+#include "GameInput.h"
+#include <algorithm>
+
+// InputBits bit index of each game key
+const int KEY_ROTATE = 0;
+const int KEY_DOWN = 3;
+
+
+/**
+ * Property constructor
+ * @param settings - repeat timing
+ */
+InputQueue::InputQueue(const InputSettings& settings)
+        : _settings{settings}, _head{0}, _tail{0}, _dropped{0} {
+    clear();
+}
+
+/**
+ * Queue a window event if it presses or releases a game key
+ * @param event - event from pollEvent()
+ * @return true if the event was a game key
+ */
+bool InputQueue::push(const sf::Event& event) {
+    if(event.type != sf::Event::KeyPressed && event.type != sf::Event::KeyReleased){
+        return false;
+    }
+    unsigned int input = keyInput(event.key.code);
+    if(input == INPUT_NONE){
+        return false;
+    }
+
+    push(now(), input, event.type == sf::Event::KeyPressed);
+    return true;
+} // push
+
+/**
+ * Queue a press or release
+ * @param time - microseconds, on the now() clock
+ * @param input - one InputBits bit
+ * @param pressed - true for a press, false for a release
+ */
+void InputQueue::push(int64_t time, unsigned int input, bool pressed) {
+    if(_tail - _head == unsigned(INPUT_QUEUE_EVENTS)){
+        ++_head; // full, the oldest goes
+        ++_dropped;
+    }
+    _events[_tail % INPUT_QUEUE_EVENTS] = {time, uint8_t(input), pressed};
+    ++_tail;
+} // push
+
+/**
+ * Take the input for an update. Events up to the update's time are
+ * applied in order, then every repeat due by then is added. Each key
+ * acts at most once per update, and moves left over are kept for the
+ * updates that follow.
+ * @param until - time the update stands for, on the now() clock
+ * @param times - receives, for each InputBits bit returned, when its
+ *                press or repeat happened, may be null
+ * @return InputBits to press for the update
+ */
+unsigned int InputQueue::takeInputs(int64_t until, int64_t times[]) {
+    while(_head != _tail && _events[_head % INPUT_QUEUE_EVENTS].time <= until){
+        const InputEvent& event = _events[_head % INPUT_QUEUE_EVENTS];
+        int key = __builtin_ctz(event.input);
+        KeyRepeat& repeat = _keys[key];
+
+        if(event.pressed && !repeat.held){
+            // key repeat events from the window are ignored, the
+            // repeats are timed here
+            repeat.held = true;
+            if(addPending(repeat, event.time)){
+                ++repeat.taps;
+            }
+            repeat.nextRepeat = event.time + repeatDelay(key, true);
+        } else if(!event.pressed){
+            // repeats still waiting stop with the key, a tap not yet
+            // taken is kept
+            repeat.held = false;
+            repeat.pending = repeat.taps;
+        }
+        ++_head;
+    }
+
+    unsigned int bits = INPUT_NONE;
+    for(int key = 0; key < 4; ++key){
+        KeyRepeat& repeat = _keys[key];
+
+        if(repeat.held && key != KEY_ROTATE){
+            int64_t interval = std::max<int64_t>(repeatDelay(key, false), 1);
+            if(repeat.nextRepeat <= until){
+                // only the last few repeats can still be used
+                int64_t repeats = (until - repeat.nextRepeat) / interval + 1;
+                int64_t skipped = std::max<int64_t>(repeats - INPUT_MAX_PENDING, 0);
+                for(int64_t step = skipped; step < repeats; ++step){
+                    addPending(repeat, repeat.nextRepeat + step * interval);
+                }
+                repeat.nextRepeat += repeats * interval;
+            }
+        }
+
+        if(repeat.pending > 0){
+            bits |= 1u << key;
+            if(times){
+                times[key] = repeat.times[0];
+            }
+            --repeat.pending;
+            repeat.taps = std::max(repeat.taps - 1, 0);
+            std::copy(repeat.times + 1, repeat.times + 1 + repeat.pending, repeat.times);
+        }
+    }
+    return bits;
+} // takeInputs
+
+/**
+ * Forget every event and held key
+ */
+void InputQueue::clear() {
+    _head = _tail = 0;
+    for(KeyRepeat& repeat : _keys){
+        repeat = {false, 0, 0, 0, {0}};
+    }
+} // clear
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * @param key - InputBits bit index
+ * @param first - true for the wait after the press
+ * @return microseconds until the key's next repeat
+ */
+int64_t InputQueue::repeatDelay(int key, bool first) {
+    if(key == KEY_DOWN){
+        return int64_t(_settings.softDropMs) * 1000;
+    }
+    return int64_t(first ? _settings.dasMs : _settings.arrMs) * 1000;
+} // repeatDelay
+
+/**
+ * Add a move to a key, moves past INPUT_MAX_PENDING are dropped
+ * @param repeat - key to add to
+ * @param time - when the press or repeat happened
+ * @return false if the move was dropped
+ */
+bool InputQueue::addPending(KeyRepeat& repeat, int64_t time) {
+    if(repeat.pending >= INPUT_MAX_PENDING){
+        return false;
+    }
+    repeat.times[repeat.pending++] = time;
+    return true;
+} // addPending
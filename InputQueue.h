@@ -0,0 +1,85 @@
+// File: InputQueue.h
+//   By: John Holik
+// Desc: Timestamped queue of key presses and releases between
+//       processEvents() and the board updates. Events keep the time they
+//       were read, so each update takes exactly the events that happened
+//       before the moment it stands for. A tap is never lost, even when
+//       several land in one frame. Holding left, right or down repeats
+//       the move: left and right wait the delayed auto shift (DAS) first,
+//       then every repeat is an auto repeat rate (ARR) interval apart.
+//       The repeat times come from the event times, not the frames.
+
+#ifndef TETRIS3_INPUTQUEUE_H
+#define TETRIS3_INPUTQUEUE_H
+#include "tetris.h"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+
+const int INPUT_QUEUE_EVENTS = 64;  // events kept before the oldest are dropped
+const int INPUT_MAX_PENDING = 3;    // moves of one key carried to later updates
+
+struct InputSettings{
+    int dasMs;       // hold time before left and right repeat
+    int arrMs;       // time between repeats
+    int softDropMs;  // time between repeats of down
+};
+
+const InputSettings DEFAULT_INPUT_SETTINGS = {167, FRAME_RATE_MS, FRAME_RATE_MS};
+
+
+class InputQueue {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    explicit InputQueue(const InputSettings& settings = DEFAULT_INPUT_SETTINGS);
+
+    // Accessors
+    // --------------------------------------------------------
+    const InputSettings& getSettings() {return _settings;}
+    void setSettings(const InputSettings& settings) {_settings = settings;}
+
+    int getDropped() {return _dropped;}
+
+    // microseconds since the queue was made, the time base of the events
+    int64_t now() {return _clock.getElapsedTime().asMicroseconds();}
+
+    // Methods
+    // --------------------------------------------------------
+    bool push(const sf::Event& event);
+    void push(int64_t time, unsigned int input, bool pressed);
+
+    unsigned int takeInputs(int64_t until, int64_t times[] = nullptr);
+
+    void clear();
+
+private:
+    struct InputEvent{
+        int64_t time;      // microseconds, from now()
+        uint8_t input;     // one InputBits bit
+        bool pressed;
+    };
+
+    struct KeyRepeat{
+        bool held;
+        int64_t nextRepeat;  // time of the next auto repeat while held
+        int pending;         // moves not yet handed to an update
+        int taps;            // presses among them, ahead of any repeats
+        int64_t times[INPUT_MAX_PENDING];  // when each pending move was pressed or repeated
+    };
+
+    InputSettings _settings;
+    sf::Clock _clock;
+
+    InputEvent _events[INPUT_QUEUE_EVENTS];
+    unsigned int _head;      // next event to take
+    unsigned int _tail;      // next free slot
+    int _dropped;            // events lost to a full queue
+
+    KeyRepeat _keys[4];      // one per InputBits bit
+
+    int64_t repeatDelay(int key, bool first);
+    static bool addPending(KeyRepeat& repeat, int64_t time);
+};
+
+
+#endif //TETRIS3_INPUTQUEUE_H
@@ -0,0 +1,83 @@
+// File: InputSource.cpp
+//   By: John Holik
+// Desc: Implementation of the headless input sources
+
+#include "InputSource.h"
+#include "GameInput.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+const int RANDOM_PRESS_CHANCE = 4; // a random source presses a key one tick in this many
+
+
+/**
+ * @param state - board before the tick
+ * @param tick - ticks run so far
+ * @return keys the bot presses
+ */
+unsigned int BotInputSource::nextInput(const BoardState& state, uint32_t /*tick*/) {
+    return _bot.nextInput(state);
+} // nextInput
+
+
+/**
+ * Read a script. Blank lines and lines starting with # are skipped.
+ * @param path - script file
+ * @return false if the file could not be read or has a bad line
+ */
+bool ScriptInputSource::load(const std::string& path) {
+    std::ifstream in{path};
+    if(!in){
+        return false;
+    }
+
+    _steps.clear();
+    _next = 0;
+
+    std::string line;
+    while(std::getline(in, line)){
+        if(line.empty() || line[0] == '#' || line[0] == '\r'){
+            continue;
+        }
+        unsigned long tick = 0;
+        unsigned int input = 0;
+        if(std::sscanf(line.c_str(), "%lu %u", &tick, &input) != 2 || input > INPUT_ALL){
+            return false;
+        }
+        _steps.push_back({uint32_t(tick), input});
+    }
+
+    std::stable_sort(_steps.begin(), _steps.end(),
+                     [](const ScriptStep& lhs, const ScriptStep& rhs) {return lhs.tick < rhs.tick;});
+    return true;
+} // load
+
+/**
+ * @param state - board before the tick
+ * @param tick - ticks run so far
+ * @return keys the script presses on this tick
+ */
+unsigned int ScriptInputSource::nextInput(const BoardState& /*state*/, uint32_t tick) {
+    unsigned int input = INPUT_NONE;
+    while(_next < _steps.size() && _steps[_next].tick <= tick){
+        if(_steps[_next].tick == tick){
+            input |= _steps[_next].input;
+        }
+        ++_next;
+    }
+    return input;
+} // nextInput
+
+
+/**
+ * @param state - board before the tick
+ * @param tick - ticks run so far
+ * @return a random key some of the time
+ */
+unsigned int RandomInputSource::nextInput(const BoardState& /*state*/, uint32_t /*tick*/) {
+    if(_randGenerator() % RANDOM_PRESS_CHANCE != 0){
+        return INPUT_NONE;
+    }
+    return 1u << (_randGenerator() % 4);
+} // nextInput
@@ -0,0 +1,75 @@
+// File: InputSource.h
+//   By: John Holik
+// Desc: Where a board's input comes from when no one is at the keyboard.
+//       A source is asked once per tick for the InputBits to press, so
+//       the bot, a fixed script or random play can drive a board
+//       headless at any speed.
+
+#ifndef TETRIS3_INPUTSOURCE_H
+#define TETRIS3_INPUTSOURCE_H
+#include "BoardState.h"
+#include "TetrisBot.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    /**
+     * @param state - board before the tick
+     * @param tick - ticks run so far
+     * @return InputBits to press this tick
+     */
+    virtual unsigned int nextInput(const BoardState& state, uint32_t tick) = 0;
+};
+
+
+// the AI player
+class BotInputSource : public InputSource {
+public:
+    explicit BotInputSource(TetrisBot& bot) : _bot{bot} { }
+
+    unsigned int nextInput(const BoardState& state, uint32_t tick) override;
+
+private:
+    TetrisBot& _bot;
+};
+
+
+// inputs read from a text file, one "TICK BITS" pair per line
+class ScriptInputSource : public InputSource {
+public:
+    ScriptInputSource() : _next{0} { }
+
+    bool load(const std::string& path);
+
+    unsigned int nextInput(const BoardState& state, uint32_t tick) override;
+
+private:
+    struct ScriptStep{
+        uint32_t tick;
+        unsigned int input;
+    };
+
+    std::vector<ScriptStep> _steps;  // in tick order
+    size_t _next;                    // first step not yet used
+};
+
+
+// a random key now and then
+class RandomInputSource : public InputSource {
+public:
+    explicit RandomInputSource(unsigned int seed) : _randGenerator{seed} { }
+
+    unsigned int nextInput(const BoardState& state, uint32_t tick) override;
+
+private:
+    std::minstd_rand _randGenerator;
+};
+
+
+#endif //TETRIS3_INPUTSOURCE_H
@@ -0,0 +1,100 @@
+// File: KickTable.cpp
+//   By: John Holik
+// Desc: Implementation of the SRS wall kick tables
+
+#include "KickTable.h"
+#include "PieceSet.h"
+
+// kicks for rotating anticlockwise out of each SRS state,
+// 0->L, R->0, 2->R and L->2
+const Kick JLSTZ_KICKS[4][KICK_TESTS] = {
+        {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}},
+        {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},
+        {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}},
+        {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}}};
+
+const Kick I_KICKS[4][KICK_TESTS] = {
+        {{0, 0}, {-1, 0}, {2, 0}, {-1, 2}, {2, -1}},
+        {{0, 0}, {2, 0}, {-1, 0}, {2, 1}, {-1, -2}},
+        {{0, 0}, {1, 0}, {-2, 0}, {1, -2}, {-2, 1}},
+        {{0, 0}, {-2, 0}, {1, 0}, {-2, -1}, {1, 2}}};
+
+// the O turns inside a 3x3 box, which moves it a cell, so its only
+// kick puts it back where it was
+const Kick O_KICKS[4] = {{1, 0}, {0, -1}, {-1, 0}, {0, 1}};
+
+
+/**
+ * Fill in the kicks of each rotation of a shape
+ * @param style - kick list the shape uses
+ * @param spawnState - SRS orientation of the shape's starting position
+ * @param lists - receives the offsets to try for each rotation
+ */
+void buildKicks(KickStyle style, int spawnState, KickList lists[4]) {
+    for(int rotation = 0; rotation < 4; ++rotation){
+        // each anticlockwise turn goes back one SRS state
+        int state = (spawnState - rotation + 4) % 4;
+        KickList& list = lists[rotation];
+
+        switch(style){
+            case KICKS_JLSTZ:
+            case KICKS_I:
+                list.count = KICK_TESTS;
+                for(int test = 0; test < KICK_TESTS; ++test){
+                    list.kicks[test] = style == KICKS_I ?
+                                       I_KICKS[state][test] : JLSTZ_KICKS[state][test];
+                }
+                break;
+            case KICKS_O:
+                list.count = 1;
+                list.kicks[0] = O_KICKS[state];
+                break;
+            default:
+                list.count = 1;
+                list.kicks[0] = Kick{0, 0};
+                break;
+        }
+    } // each rotation
+} // buildKicks
+
+
+/**
+ * Kicks are built with the piece set (see PieceSet.h)
+ * @param type - shape type
+ * @param rotation - rotations from the starting position before this one
+ * @return offsets to try, in order, for the next rotation
+ */
+const KickList& rotationKicks(Tetromino::ShapeType type, int rotation) {
+    return pieceSet().getKicks(type, rotation);
+} // rotationKicks
+
+
+/**
+ * Try every kick of a rotation against the board in one pass. A kick
+ * never lifts a block above the top row, the board has no hidden rows.
+ * @param rows - padded row masks, index 0 is the bottom row
+ * @param type - shape being rotated
+ * @param rotation - its rotation before turning
+ * @param column - grid column of the shape's left side
+ * @param row - grid row of the shape's top row
+ * @return index of the first kick that fits, -1 if none do
+ */
+int findKick(const uint32_t rows[], Tetromino::ShapeType type, int rotation,
+             int column, int row) {
+    const KickList& list = rotationKicks(type, rotation);
+    const ShapeMask& mask = shapeMask(type, rotation + 1);
+
+    // rows of the box above the shape's first block
+    int emptyTop = pieceSet().getBox(type, rotation + 1).top;
+
+    unsigned int fits = 0;
+    for(int test = 0; test < list.count; ++test){
+        int kickColumn = column + list.kicks[test].column;
+        int kickRow = row + list.kicks[test].row;
+
+        bool fit = kickRow - emptyTop < GAME_ROWS && !hasCollision(rows, mask, kickColumn, kickRow);
+        fits |= unsigned(fit) << test;
+    }
+
+    return fits == 0 ? -1 : __builtin_ctz(fits);
+} // findKick
@@ -0,0 +1,53 @@
+// File: KickTable.h
+//   By: John Holik
+// Desc: Super Rotation System wall kicks. Each shape and rotation has a
+//       short list of offsets to try when the rotated shape doesn't fit
+//       where it is. The first offset that fits is used. The lists come
+//       from the standard SRS tables. Our shapes start in different SRS
+//       orientations and always rotate anticlockwise, so each list is
+//       looked up through the shape's starting orientation. The
+//       tables for each piece are built with the piece set (PieceSet.h).
+
+#ifndef TETRIS3_KICKTABLE_H
+#define TETRIS3_KICKTABLE_H
+#include "tetris.h"
+#include "Tetromino.h"
+#include "Collision.h"
+#include <cstdint>
+
+const int KICK_TESTS = 5; // most offsets tried for one rotation
+
+// which SRS kick list a shape uses
+enum KickStyle{
+    KICKS_NONE,   // rotates in place or not at all
+    KICKS_JLSTZ,
+    KICKS_I,
+    KICKS_O
+};
+
+// SRS orientations, clockwise from the standard spawn position
+enum SrsState{
+    SRS_0,
+    SRS_R,
+    SRS_2,
+    SRS_L
+};
+
+struct Kick{
+    int8_t column;   // columns to the right
+    int8_t row;      // rows up
+};
+
+struct KickList{
+    int count;
+    Kick kicks[KICK_TESTS];
+};
+
+void buildKicks(KickStyle style, int spawnState, KickList lists[4]);
+
+const KickList& rotationKicks(Tetromino::ShapeType type, int rotation);
+
+int findKick(const uint32_t rows[], Tetromino::ShapeType type, int rotation,
+             int column, int row);
+
+#endif //TETRIS3_KICKTABLE_H
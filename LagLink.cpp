@@ -0,0 +1,127 @@
+// File: LagLink.cpp
+//   By: John Holik
+// Desc: Implementation of the UDP link with lag simulation
+
+#include "LagLink.h"
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+
+/**
+ * Property constructor, nothing is opened until open()
+ * @param lag - delay, jitter and loss added to sent packets
+ */
+LagLink::LagLink(const LagSettings& lag)
+        : _socket{-1}, _remotePort{0}, _lag{lag}, _randGenerator{std::random_device{}()} { }
+
+/**
+ * Destructor closes the socket, held back packets are lost
+ */
+LagLink::~LagLink() {
+    if(_socket >= 0){
+        close(_socket);
+    }
+}
+
+/**
+ * Bind a UDP socket on 127.0.0.1
+ * @param localPort - port to receive on
+ * @param remotePort - port the other game receives on
+ * @return false if the port could not be bound
+ */
+bool LagLink::open(int localPort, int remotePort) {
+    _socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(uint16_t(localPort));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if(_socket < 0 || bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0){
+        return false;
+    }
+    _remotePort = remotePort;
+    return true;
+} // open
+
+/**
+ * Send a packet, or hold it back when simulating lag
+ * @param data - packet bytes
+ * @param size - packet size, at most LINK_MAX_PACKET
+ */
+void LagLink::send(const void* data, int size) {
+    if(_lag.loss > 0.f && std::uniform_real_distribution<float>(0.f, 1.f)(_randGenerator) < _lag.loss){
+        return; // lost on the way
+    }
+    if(_lag.delayMs <= 0 && _lag.jitterMs <= 0){
+        sendNow(data, size);
+        return;
+    }
+
+    HeldPacket packet;
+    int delay = _lag.delayMs;
+    if(_lag.jitterMs > 0){
+        delay += std::uniform_int_distribution<>(0, _lag.jitterMs)(_randGenerator);
+    }
+    packet.due = Clock::now() + std::chrono::milliseconds(delay);
+    packet.size = std::min(size, LINK_MAX_PACKET);
+    std::memcpy(packet.data, data, packet.size);
+
+    // jitter can put a packet ahead of ones sent before it, like a real network
+    auto position = std::upper_bound(_held.begin(), _held.end(), packet,
+                                     [](const HeldPacket& lhs, const HeldPacket& rhs) {return lhs.due < rhs.due;});
+    _held.insert(position, packet);
+
+    flush();
+} // send
+
+/**
+ * @param data - receives one packet
+ * @param size - room in data
+ * @return packet size, 0 if nothing has arrived
+ */
+int LagLink::receive(void* data, int size) {
+    flush();
+
+    if(_socket < 0){
+        return 0;
+    }
+    ssize_t received = recv(_socket, data, size_t(size), 0);
+    return received > 0 ? int(received) : 0;
+} // receive
+
+/**
+ * Send every held back packet whose delay is up
+ */
+void LagLink::flush() {
+    auto now = Clock::now();
+    while(!_held.empty() && _held.front().due <= now){
+        sendNow(_held.front().data, _held.front().size);
+        _held.pop_front();
+    }
+} // flush
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * @param data - packet bytes
+ * @param size - packet size
+ */
+void LagLink::sendNow(const void* data, int size) {
+    if(_socket < 0){
+        return;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(uint16_t(_remotePort));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    sendto(_socket, data, size_t(size), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+} // sendNow
@@ -0,0 +1,66 @@
+// File: LagLink.h
+//   By: John Holik
+// Desc: UDP link between two games on the same machine with a lag
+//       simulator. Sent packets can be held back by a fixed delay plus
+//       random jitter, or dropped, before they reach the socket, so
+//       network play can be tried out on loopback.
+
+#ifndef TETRIS3_LAGLINK_H
+#define TETRIS3_LAGLINK_H
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+
+const int LINK_MAX_PACKET = 512; // largest packet sent or received
+
+struct LagSettings{
+    int delayMs;     // added to every packet
+    int jitterMs;    // up to this much more, at random
+    float loss;      // share of packets dropped, 0 to 1
+};
+
+const LagSettings NO_LAG = {0, 0, 0.f};
+
+
+class LagLink {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    explicit LagLink(const LagSettings& lag = NO_LAG);
+
+    ~LagLink(); // destructor, closes the socket
+
+    LagLink(const LagLink& other) = delete;
+    LagLink& operator=(const LagLink& rhs) = delete;
+
+    // Methods
+    // --------------------------------------------------------
+    bool open(int localPort, int remotePort);
+
+    void send(const void* data, int size);
+    int receive(void* data, int size);
+
+    void flush(); // send held back packets that are due
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct HeldPacket{
+        Clock::time_point due;
+        int size;
+        uint8_t data[LINK_MAX_PACKET];
+    };
+
+    int _socket;
+    int _remotePort;
+    LagSettings _lag;
+    std::deque<HeldPacket> _held;  // in the order they are due
+    std::mt19937 _randGenerator;
+
+    void sendNow(const void* data, int size);
+};
+
+
+#endif //TETRIS3_LAGLINK_H
@@ -0,0 +1,108 @@
+// File: LatencyProbe.cpp
+//   By: John Holik
+// Desc: Implementation of the input latency probe
+
+#include "LatencyProbe.h"
+#include <algorithm>
+#include <string>
+
+
+/**
+ * Default constructor, no samples yet
+ */
+LatencyProbe::LatencyProbe() : _pendingCount{0}, _toUpdate{0}, _toDisplay{0}, _samples{0}, _worst{0} { }
+
+/**
+ * An update used an input
+ * @param inputTime - when the input was read, microseconds
+ * @param updateTime - when the update ran, same clock
+ */
+void LatencyProbe::consumed(int64_t inputTime, int64_t updateTime) {
+    addSample(_toUpdate, updateTime - inputTime);
+    if(_pendingCount < LATENCY_MAX_PENDING){
+        _pending[_pendingCount++] = inputTime;
+    }
+} // consumed
+
+/**
+ * A frame returned from window.display(), every input used by the
+ * updates before it is now on screen
+ * @param displayTime - when display() returned, microseconds
+ */
+void LatencyProbe::displayed(int64_t displayTime) {
+    for(int index = 0; index < _pendingCount; ++index){
+        int64_t latency = displayTime - _pending[index];
+        addSample(_toDisplay, latency);
+        _worst = std::max(_worst, latency);
+        ++_samples;
+    }
+    _pendingCount = 0;
+} // displayed
+
+/**
+ * @param percent - 0 to 100
+ * @return input to display latency that percent of inputs are within, in ms
+ */
+int LatencyProbe::percentile(float percent) {
+    return histogramPercentile(_toDisplay, _samples, percent);
+}
+
+/**
+ * Print the latency distribution
+ * @param out - stream to print to
+ */
+void LatencyProbe::report(std::ostream& out) {
+    out << _samples << " inputs" << std::endl;
+    if(_samples == 0){
+        return;
+    }
+
+    const float PERCENTS[] = {50.f, 90.f, 99.f};
+    for(float percent : PERCENTS){
+        out << "p" << percent << ": update " << histogramPercentile(_toUpdate, _samples, percent)
+            << " ms, display " << histogramPercentile(_toDisplay, _samples, percent) << " ms" << std::endl;
+    }
+    out << "worst: display " << _worst / 1000 << " ms" << std::endl;
+
+    // histogram of input to display, one row per non-empty millisecond
+    uint32_t most = *std::max_element(_toDisplay, _toDisplay + LATENCY_BUCKETS);
+    for(int bucket = 0; bucket < LATENCY_BUCKETS; ++bucket){
+        if(_toDisplay[bucket] == 0){
+            continue;
+        }
+        int bar = int(_toDisplay[bucket] * 50 / most);
+        out << (bucket == LATENCY_BUCKETS - 1 ? ">=" : "  ") << bucket << " ms "
+            << std::string(std::max(bar, 1), '#') << ' ' << _toDisplay[bucket] << std::endl;
+    }
+} // report
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * @param histogram - millisecond buckets
+ * @param samples - samples in the histogram
+ * @param percent - 0 to 100
+ * @return first bucket that reaches the percent
+ */
+int LatencyProbe::histogramPercentile(const uint32_t histogram[], int samples, float percent) {
+    uint64_t wanted = uint64_t(samples * percent / 100.f + 0.5f);
+    uint64_t seen = 0;
+    for(int bucket = 0; bucket < LATENCY_BUCKETS; ++bucket){
+        seen += histogram[bucket];
+        if(seen >= wanted && seen > 0){
+            return bucket;
+        }
+    }
+    return LATENCY_BUCKETS - 1;
+} // histogramPercentile
+
+/**
+ * @param histogram - millisecond buckets
+ * @param micros - latency in microseconds
+ */
+void LatencyProbe::addSample(uint32_t histogram[], int64_t micros) {
+    int64_t bucket = std::max<int64_t>(micros / 1000, 0);
+    ++histogram[std::min<int64_t>(bucket, LATENCY_BUCKETS - 1)];
+} // addSample
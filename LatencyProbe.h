@@ -0,0 +1,50 @@
+// File: LatencyProbe.h
+//   By: John Holik
+// Desc: Measures input latency end to end. Each game input is followed
+//       from the moment processEvents() read it, through the board
+//       update that used it, to the return of the window.display()
+//       that first showed that update. The delays go into millisecond
+//       histograms, and report() prints the distribution.
+
+#ifndef TETRIS3_LATENCYPROBE_H
+#define TETRIS3_LATENCYPROBE_H
+#include <cstdint>
+#include <ostream>
+
+const int LATENCY_BUCKETS = 250;       // 1 ms each, the last also holds anything longer
+const int LATENCY_MAX_PENDING = 64;    // inputs updated but not yet on screen
+
+
+class LatencyProbe {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    LatencyProbe();
+
+    // Accessors
+    // --------------------------------------------------------
+    int getSamples() {return _samples;}
+
+    // Methods
+    // --------------------------------------------------------
+    void consumed(int64_t inputTime, int64_t updateTime);
+    void displayed(int64_t displayTime);
+
+    int percentile(float percent);  // input to display, in ms
+    void report(std::ostream& out);
+
+private:
+    int64_t _pending[LATENCY_MAX_PENDING];  // input times waiting for a frame
+    int _pendingCount;
+
+    uint32_t _toUpdate[LATENCY_BUCKETS];    // input to the update that used it
+    uint32_t _toDisplay[LATENCY_BUCKETS];   // input to the frame that showed it
+    int _samples;
+    int64_t _worst;                         // longest input to display, microseconds
+
+    static int histogramPercentile(const uint32_t histogram[], int samples, float percent);
+    static void addSample(uint32_t histogram[], int64_t micros);
+};
+
+
+#endif //TETRIS3_LATENCYPROBE_H
@@ -0,0 +1,113 @@
+// File: LockFreeQueue.h
+//   By: John Holik
+// Desc: Bounded queue any number of threads can push to and pop from
+//       without locks. Each cell carries a sequence number that says
+//       whether it is ready to be written or read on the current lap
+//       of the ring, so a push or pop is one compare-and-swap on the
+//       tail or head plus a store to the cell.
+
+#ifndef TETRIS3_LOCKFREEQUEUE_H
+#define TETRIS3_LOCKFREEQUEUE_H
+#include <atomic>
+#include <cstddef>
+
+
+template <typename T>
+class LockFreeQueue {
+public:
+    // Constructors
+    // --------------------------------------------------------
+
+    /**
+     * @param capacity - items the queue holds, rounded up to a power of two
+     */
+    explicit LockFreeQueue(size_t capacity) : _head{0}, _tail{0} {
+        size_t size = 2;
+        while(size < capacity){
+            size <<= 1;
+        }
+        _mask = size - 1;
+
+        _cells = new Cell[size];
+        for(size_t cell = 0; cell < size; ++cell){
+            _cells[cell].sequence.store(cell, std::memory_order_relaxed);
+        }
+    }
+
+    ~LockFreeQueue() {delete[] _cells;} // destructor
+
+    LockFreeQueue(const LockFreeQueue& other) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue& rhs) = delete;
+
+    // Methods
+    // --------------------------------------------------------
+
+    /**
+     * @param item - item to add
+     * @return false if the queue is full
+     */
+    bool tryPush(const T& item) {
+        size_t position = _tail.load(std::memory_order_relaxed);
+        while(true){
+            Cell& cell = _cells[position & _mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            long difference = long(sequence) - long(position);
+
+            if(difference == 0){
+                // cell is free on this lap, claim it
+                if(_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    cell.item = item;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(difference < 0){
+                return false; // still holds an item from the last lap
+            } else {
+                position = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @param item - receives the oldest item
+     * @return false if the queue is empty
+     */
+    bool tryPop(T& item) {
+        size_t position = _head.load(std::memory_order_relaxed);
+        while(true){
+            Cell& cell = _cells[position & _mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            long difference = long(sequence) - long(position + 1);
+
+            if(difference == 0){
+                if(_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    item = cell.item;
+                    // free for the push one lap later
+                    cell.sequence.store(position + _mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(difference < 0){
+                return false; // not written yet
+            } else {
+                position = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell{
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    Cell* _cells;
+    size_t _mask;
+
+    // kept on separate cache lines so pushing and popping threads
+    // don't slow each other down
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+};
+
+
+#endif //TETRIS3_LOCKFREEQUEUE_H
@@ -0,0 +1,293 @@
+// File: Metrics.cpp
+//   By: John Holik
+// Desc: Implementation of the metrics registry and the Prometheus exporter
+
+#include "Metrics.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+const int POLL_WAIT_MS = 200; // how often the export thread checks for stop
+
+// local functions
+static void writeCounter(std::ostream& out, const char* name, const char* help, const MetricCounter& counter);
+
+
+/**
+ * Default constructor, every shard starts at 0
+ */
+MetricCounter::MetricCounter() {
+    for(Shard& shard : _shards){
+        shard.count.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @return count over every shard
+ */
+uint64_t MetricCounter::value() const {
+    uint64_t total = 0;
+    for(const Shard& shard : _shards){
+        total += shard.count.load(std::memory_order_relaxed);
+    }
+    return total;
+} // value
+
+/**
+ * @return shard of the calling thread, fixed the first time it counts
+ */
+int MetricCounter::shardIndex() {
+    static std::atomic<int> nextShard{0};
+    static thread_local int shard = nextShard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+
+/**
+ * Default constructor, nothing observed
+ */
+MetricSummary::MetricSummary() : _sumMicros{0}, _count{0} {
+    for(std::atomic<uint32_t>& bucket : _buckets){
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @param micros - duration to add
+ */
+void MetricSummary::observe(int64_t micros) {
+    int64_t bucket = micros < 0 ? 0 : micros / 1000;
+    if(bucket >= METRIC_BUCKETS){
+        bucket = METRIC_BUCKETS - 1;
+    }
+    _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    _sumMicros.fetch_add(uint64_t(micros < 0 ? 0 : micros), std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+} // observe
+
+/**
+ * @param fraction - 0 to 1
+ * @return upper edge of the bucket the fraction of durations falls in, seconds
+ */
+double MetricSummary::quantile(float fraction) const {
+    uint64_t total = 0;
+    for(const std::atomic<uint32_t>& bucket : _buckets){
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if(total == 0){
+        return 0.0;
+    }
+
+    uint64_t wanted = uint64_t(double(total) * fraction + 0.5);
+    uint64_t seen = 0;
+    for(int bucket = 0; bucket < METRIC_BUCKETS; ++bucket){
+        seen += _buckets[bucket].load(std::memory_order_relaxed);
+        if(seen >= wanted && seen > 0){
+            return (bucket + 1) / 1000.0;
+        }
+    }
+    return METRIC_BUCKETS / 1000.0;
+} // quantile
+
+/**
+ * @return total of every duration, seconds
+ */
+double MetricSummary::sum() const {
+    return double(_sumMicros.load(std::memory_order_relaxed)) / 1e6;
+}
+
+/**
+ * @return durations observed
+ */
+uint64_t MetricSummary::count() const {
+    return _count.load(std::memory_order_relaxed);
+}
+
+
+/**
+ * @return the metrics of this process
+ */
+GameMetrics& gameMetrics() {
+    static GameMetrics metrics;
+    return metrics;
+}
+
+/**
+ * @return every metric in the Prometheus text exposition format
+ */
+std::string formatMetrics() {
+    GameMetrics& metrics = gameMetrics();
+    std::ostringstream out;
+
+    writeCounter(out, "tetris_frames_rendered_total", "Frames drawn to the window.", metrics.framesRendered);
+    writeCounter(out, "tetris_updates_total", "Board updates run.", metrics.updatesRun);
+    writeCounter(out, "tetris_pieces_spawned_total", "Shapes spawned.", metrics.piecesSpawned);
+    writeCounter(out, "tetris_locks_total", "Shapes locked into a board.", metrics.locks);
+    writeCounter(out, "tetris_lines_cleared_total", "Rows cleared.", metrics.linesCleared);
+
+    out << "# HELP tetris_frame_seconds Time between frames drawn.\n"
+        << "# TYPE tetris_frame_seconds summary\n";
+    const float QUANTILES[] = {0.5f, 0.9f, 0.99f};
+    for(float fraction : QUANTILES){
+        out << "tetris_frame_seconds{quantile=\"" << fraction << "\"} "
+            << metrics.frameTime.quantile(fraction) << '\n';
+    }
+    out << "tetris_frame_seconds_sum " << metrics.frameTime.sum() << '\n'
+        << "tetris_frame_seconds_count " << metrics.frameTime.count() << '\n';
+
+    out << "# HELP tetris_allocations_per_frame Heap allocations during the last frame.\n"
+        << "# TYPE tetris_allocations_per_frame gauge\n"
+        << "tetris_allocations_per_frame " << metrics.allocationsPerFrame.value() << '\n';
+
+    return out.str();
+} // formatMetrics
+
+
+/**
+ * Property constructor, nothing runs until start()
+ * @param path - file to write every METRICS_INTERVAL_MS, empty for none
+ * @param port - HTTP port on 127.0.0.1 to serve on, 0 for none
+ */
+MetricsExporter::MetricsExporter(const std::string& path, int port)
+        : _path{path}, _port{port}, _listener{-1}, _stopping{false} { }
+
+/**
+ * Destructor stops the export thread, the file gets the final values
+ */
+MetricsExporter::~MetricsExporter() {
+    _stopping = true;
+    if(_thread.joinable()){
+        _thread.join();
+    }
+    if(_listener >= 0){
+        close(_listener);
+    }
+    if(!_path.empty()){
+        writeFile();
+    }
+} // destructor
+
+/**
+ * Open the HTTP port, if any, and start the export thread
+ * @return false if the port could not be opened
+ */
+bool MetricsExporter::start() {
+    if(_port > 0){
+        _listener = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(uint16_t(_port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if(_listener < 0 || bind(_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+           listen(_listener, SOMAXCONN) < 0){
+            return false;
+        }
+    }
+
+    _thread = std::thread{&MetricsExporter::exportLoop, this};
+    return true;
+} // start
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * Write the file on schedule and answer HTTP requests until stopped
+ */
+void MetricsExporter::exportLoop() {
+    auto nextWrite = std::chrono::steady_clock::now();
+
+    while(!_stopping){
+        if(!_path.empty() && std::chrono::steady_clock::now() >= nextWrite){
+            writeFile();
+            nextWrite += std::chrono::milliseconds(METRICS_INTERVAL_MS);
+        }
+
+        if(_listener < 0){
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_WAIT_MS));
+            continue;
+        }
+
+        pollfd waiting{_listener, POLLIN, 0};
+        if(poll(&waiting, 1, POLL_WAIT_MS) > 0){
+            int client = accept(_listener, nullptr, nullptr);
+            if(client >= 0){
+                serveClient(client);
+                close(client);
+            }
+        }
+    }
+} // exportLoop
+
+/**
+ * Replace the metrics file, written to a temporary file first so a
+ * scraper never reads half of it
+ * @return false if the file could not be written
+ */
+bool MetricsExporter::writeFile() {
+    std::string temporary = _path + ".tmp";
+    {
+        std::ofstream out{temporary};
+        out << formatMetrics();
+        if(!out){
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), _path.c_str()) == 0;
+} // writeFile
+
+/**
+ * Answer one HTTP request with the metrics, whatever path it asks for
+ * @param client - connected socket
+ */
+void MetricsExporter::serveClient(int client) {
+    // the request itself doesn't matter, read what has arrived
+    char request[1024];
+    pollfd waiting{client, POLLIN, 0};
+    if(poll(&waiting, 1, POLL_WAIT_MS) > 0){
+        recv(client, request, sizeof(request), 0);
+    }
+
+    std::string body = formatMetrics();
+    std::string response = "HTTP/1.0 200 OK\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while(sent < response.size()){
+        ssize_t count = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if(count <= 0){
+            break;
+        }
+        sent += size_t(count);
+    }
+} // serveClient
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * @param out - stream to write to
+ * @param name - metric name
+ * @param help - description
+ * @param counter - counter to write
+ */
+static void writeCounter(std::ostream& out, const char* name, const char* help, const MetricCounter& counter) {
+    out << "# HELP " << name << ' ' << help << '\n'
+        << "# TYPE " << name << " counter\n"
+        << name << ' ' << counter.value() << '\n';
+}
@@ -0,0 +1,117 @@
+// File: Metrics.h
+//   By: John Holik
+// Desc: Runtime metrics in the Prometheus text format. Counters are
+//       split over cache-line sized shards picked by thread, so boards
+//       updating on many threads don't fight over one counter. The
+//       shards are added up when the metrics are exported. A
+//       MetricsExporter thread writes the text to a file every few
+//       seconds, serves it on a loopback HTTP port, or both.
+
+#ifndef TETRIS3_METRICS_H
+#define TETRIS3_METRICS_H
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+const int METRIC_SHARDS = 16;           // counter slots, threads share them round robin
+const int METRIC_BUCKETS = 200;         // 1 ms each, the last also holds anything longer
+const int METRICS_INTERVAL_MS = 5000;   // time between file writes
+
+
+class MetricCounter {
+public:
+    MetricCounter();
+
+    /**
+     * @param amount - added to the count
+     */
+    void add(uint64_t amount = 1) {
+        _shards[shardIndex()].count.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard{
+        std::atomic<uint64_t> count;
+    };
+    Shard _shards[METRIC_SHARDS];
+
+    static int shardIndex();
+};
+
+
+class MetricGauge {
+public:
+    MetricGauge() : _value{0.0} { }
+
+    void set(double value) {_value.store(value, std::memory_order_relaxed);}
+    double value() const {return _value.load(std::memory_order_relaxed);}
+
+private:
+    std::atomic<double> _value;
+};
+
+
+// durations in millisecond buckets, exported as quantiles
+class MetricSummary {
+public:
+    MetricSummary();
+
+    void observe(int64_t micros);
+
+    double quantile(float fraction) const;  // seconds
+    double sum() const;                     // seconds
+    uint64_t count() const;
+
+private:
+    std::atomic<uint32_t> _buckets[METRIC_BUCKETS];
+    std::atomic<uint64_t> _sumMicros;
+    std::atomic<uint64_t> _count;
+};
+
+
+struct GameMetrics{
+    MetricCounter framesRendered;
+    MetricCounter updatesRun;
+    MetricCounter piecesSpawned;
+    MetricCounter locks;
+    MetricCounter linesCleared;
+    MetricSummary frameTime;
+    MetricGauge allocationsPerFrame;
+};
+
+GameMetrics& gameMetrics();
+std::string formatMetrics();
+
+
+class MetricsExporter {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    MetricsExporter(const std::string& path, int port);
+
+    ~MetricsExporter(); // destructor, writes once more and stops
+
+    MetricsExporter(const MetricsExporter& other) = delete;
+    MetricsExporter& operator=(const MetricsExporter& rhs) = delete;
+
+    // Methods
+    // --------------------------------------------------------
+    bool start();
+
+private:
+    std::string _path;   // file to write, empty for none
+    int _port;           // HTTP port on 127.0.0.1, 0 for none
+    int _listener;
+    std::atomic<bool> _stopping;
+    std::thread _thread;
+
+    void exportLoop();
+    bool writeFile();
+    void serveClient(int client);
+};
+
+
+#endif //TETRIS3_METRICS_H
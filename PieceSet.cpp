@@ -0,0 +1,315 @@
+// File: PieceSet.cpp
+//   By: John Holik
+// Desc: Implementation of the piece set tables and loader
+
+#include "PieceSet.h"
+#include "ShapeI.h"
+#include "ShapeJ.h"
+#include "ShapeL.h"
+#include "ShapeO.h"
+#include "ShapeS.h"
+#include "ShapeT.h"
+#include "ShapeZ.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cctype>
+
+// local functions
+static PieceSet& activePieceSet();
+static int parseColor(const std::string& name);
+static int parseKicks(const std::string& name);
+static int parseSpawn(const std::string& name);
+
+
+// Constructors
+// ------------------------------------------------------------
+
+/**
+ * Default constructor makes the standard set, the pieces are numbered
+ * in ShapeType order so a ShapeType is also a piece number
+ */
+PieceSet::PieceSet() {
+    _count = 0;
+
+    Tetromino* shapes[Tetromino::SHAPE_COUNT] = {
+            new ShapeI(), new ShapeJ(), new ShapeL(), new ShapeO(),
+            new ShapeS(), new ShapeT(), new ShapeZ()};
+    const char* names[Tetromino::SHAPE_COUNT] = {"I", "J", "L", "O", "S", "T", "Z"};
+    const KickStyle kicks[Tetromino::SHAPE_COUNT] = {
+            KICKS_I, KICKS_JLSTZ, KICKS_JLSTZ, KICKS_O, KICKS_JLSTZ, KICKS_JLSTZ, KICKS_JLSTZ};
+
+    // SRS orientation each shape starts in
+    const int spawnStates[Tetromino::SHAPE_COUNT] = {
+            SRS_L, SRS_L, SRS_R, SRS_0, SRS_2, SRS_2, SRS_2};
+
+    for(int type = 0; type < Tetromino::SHAPE_COUNT; ++type){
+        addPiece(names[type], type + 1, kicks[type], spawnStates[type], *shapes[type]);
+        delete shapes[type];
+    }
+} // default
+
+
+// Methods
+// ------------------------------------------------------------
+
+/**
+ * Replace the set with the pieces in a file, see PieceSet.h for the
+ * format. The set is only changed if the whole file is read.
+ * @param path - piece set file
+ * @return false if the file is missing, has a bad piece or no pieces
+ */
+bool PieceSet::load(const std::string& path) {
+    std::ifstream in{path};
+    if(!in){
+        return false;
+    }
+
+    PieceSet* loaded = new PieceSet();
+    loaded->_count = 0;
+
+    bool good = true;
+    bool inPiece = false;          // read a piece line, the drawing follows
+    std::string name;
+    int color = 0;
+    int kicks = 0;
+    int spawn = 0;
+    std::vector<std::string> drawing;
+
+    std::string line;
+    bool more = true;
+    while(good && more){
+        more = bool(std::getline(in, line));
+        if(!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }
+        bool ends = !more || line.empty() || line.compare(0, 5, "piece") == 0;
+
+        if(inPiece && ends){
+            // square the drawing so it turns about its middle
+            int size = int(drawing.size());
+            for(const std::string& row : drawing){
+                size = std::max(size, int(row.size()));
+            }
+            good = size > 0 && size <= SHAPE_MAX_SIZE;
+
+            int blocks[SHAPE_MAX_SIZE * SHAPE_MAX_SIZE] = {0};
+            for(int row = 0; good && row < int(drawing.size()); ++row){
+                for(int column = 0; column < int(drawing[row].size()); ++column){
+                    blocks[row * size + column] = drawing[row][column] == '#' || drawing[row][column] == 'X';
+                }
+            }
+
+            if(good){
+                Tetromino shape{size, size, blocks};
+                good = loaded->addPiece(name.c_str(), color, KickStyle(kicks), spawn, shape);
+            }
+            inPiece = false;
+            drawing.clear();
+        } else if(inPiece){
+            drawing.push_back(line);
+            continue;
+        }
+
+        if(!more || line.empty() || line[0] == '#'){
+            continue; // blank lines and comments between pieces
+        }
+
+        std::istringstream header{line};
+        std::string keyword;
+        std::string colorName;
+        std::string kicksName = "jlstz";
+        std::string spawnName = "0";
+        name.clear();
+        header >> keyword >> name >> colorName >> kicksName >> spawnName;
+
+        color = parseColor(colorName);
+        kicks = parseKicks(kicksName);
+        spawn = parseSpawn(spawnName);
+        good = keyword == "piece" && !name.empty() && name.size() < PIECE_NAME_MAX &&
+               color > 0 && kicks >= 0 && spawn >= 0;
+        inPiece = true;
+    } // each line
+
+    good = good && loaded->_count > 0;
+    if(good){
+        std::memcpy(_pieces, loaded->_pieces, sizeof(_pieces));
+        std::memcpy(_masks, loaded->_masks, sizeof(_masks));
+        std::memcpy(_kicks, loaded->_kicks, sizeof(_kicks));
+        _count = loaded->_count;
+    }
+    delete loaded;
+
+    return good;
+} // load
+
+
+/**
+ * Add a piece, building the tables for each of its rotations
+ * @param name - short name of the piece
+ * @param color - cell color index, 1 to SHAPE_COUNT
+ * @param kicks - wall kick list the piece uses
+ * @param spawnState - SRS orientation of the piece as given
+ * @param shape - the piece's blocks, turned while building the tables
+ * @return false if the set is full or the piece is empty or too big
+ */
+bool PieceSet::addPiece(const char* name, int color, KickStyle kicks, int spawnState,
+                        Tetromino& shape) {
+    if(_count >= PIECE_SET_MAX || shape.getRows() > SHAPE_MAX_SIZE ||
+       shape.getColumns() > SHAPE_MAX_SIZE){
+        return false;
+    }
+
+    PieceInfo& piece = _pieces[_count];
+    std::strncpy(piece.name, name, PIECE_NAME_MAX - 1);
+    piece.name[PIECE_NAME_MAX - 1] = '\0';
+    piece.color = color;
+    piece.blocks = 0;
+
+    for(int rotation = 0; rotation < 4; ++rotation){
+        ShapeMask& mask = _masks[_count][rotation];
+        buildShapeMask(shape, mask);
+        shape.rotate();
+
+        // box around the blocks
+        uint32_t columns = 0;
+        int top = -1;
+        int bottom = -1;
+        for(int row = 0; row < mask.rows; ++row){
+            if(mask.bits[row]){
+                top = top < 0 ? row : top;
+                bottom = row;
+                columns |= mask.bits[row];
+            }
+        }
+        if(top < 0){
+            return false; // no blocks
+        }
+
+        PieceBox& box = piece.boxes[rotation];
+        box.left = int8_t(__builtin_ctz(columns));
+        box.top = int8_t(top);
+        box.columns = int8_t(32 - __builtin_clz(columns) - box.left);
+        box.rows = int8_t(bottom - top + 1);
+
+        if(rotation == 0){
+            for(int row = 0; row < mask.rows; ++row){
+                piece.blocks += __builtin_popcount(mask.bits[row]);
+            }
+        }
+    } // each rotation
+
+    buildKicks(kicks, spawnState, _kicks[_count]);
+    ++_count;
+    return true;
+} // addPiece
+
+/**
+ * Hash everything about the pieces that changes how a game plays, so a
+ * replay or a client can tell it is following the same set
+ * @return FNV-1a hash of the colors, rotations and wall kicks
+ */
+uint32_t PieceSet::hash() const {
+    uint32_t hash = 0x811C9DC5u;
+    auto add = [&hash](int value) {
+        for(int byte = 0; byte < 4; ++byte){
+            hash = (hash ^ ((uint32_t(value) >> (byte * 8)) & 0xFFu)) * 0x01000193u;
+        }
+    };
+
+    add(_count);
+    for(int piece = 0; piece < _count; ++piece){
+        add(_pieces[piece].color);
+
+        for(int rotation = 0; rotation < 4; ++rotation){
+            const ShapeMask& mask = _masks[piece][rotation];
+            add(mask.rows);
+            for(int row = 0; row < mask.rows; ++row){
+                add(int(mask.bits[row]));
+            }
+
+            const KickList& kicks = _kicks[piece][rotation];
+            add(kicks.count);
+            for(int test = 0; test < kicks.count; ++test){
+                add(kicks.kicks[test].column);
+                add(kicks.kicks[test].row);
+            }
+        } // each rotation
+    } // each piece
+    return hash;
+} // hash
+
+
+/**
+ * @return the set games are played with
+ */
+const PieceSet& pieceSet() {
+    return activePieceSet();
+} // pieceSet
+
+
+/**
+ * Play with the pieces in a file from now on. Call before any board
+ * or search starts, the tables aren't locked while they change.
+ * @param path - piece set file
+ * @return false if the file could not be read, the set is unchanged
+ */
+bool loadPieceSet(const std::string& path) {
+    return activePieceSet().load(path);
+} // loadPieceSet
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * @return the set games are played with, the standard seven to start
+ */
+static PieceSet& activePieceSet() {
+    static PieceSet active;
+    return active;
+}
+
+/**
+ * @param name - color number or the letter of the shape with that color
+ * @return cell color index, 0 if unknown
+ */
+static int parseColor(const std::string& name) {
+    static const std::string LETTERS = "ijlostz";
+
+    int color = 0;
+    if(name.size() == 1 && name[0] >= '1' && name[0] < '1' + Tetromino::SHAPE_COUNT){
+        color = name[0] - '0';
+    } else if(name.size() == 1 && LETTERS.find(char(std::tolower(name[0]))) != std::string::npos){
+        color = int(LETTERS.find(char(std::tolower(name[0])))) + 1;
+    }
+    return color;
+}
+
+/**
+ * @param name - kick list name
+ * @return KickStyle, -1 if unknown
+ */
+static int parseKicks(const std::string& name) {
+    static const char* NAMES[] = {"none", "jlstz", "i", "o"};
+
+    for(int style = KICKS_NONE; style <= KICKS_O; ++style){
+        if(name == NAMES[style]){
+            return style;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @param name - SRS state, 0 r 2 or l
+ * @return SrsState, -1 if unknown
+ */
+static int parseSpawn(const std::string& name) {
+    static const std::string STATES = "0r2l";
+
+    size_t state = name.size() == 1 ? STATES.find(char(std::tolower(name[0]))) : std::string::npos;
+    return state == std::string::npos ? -1 : int(state);
+}
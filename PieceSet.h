@@ -0,0 +1,83 @@
+// File: PieceSet.h
+//   By: John Holik
+// Desc: The pieces a game is played with. Every piece is turned into
+//       tables once, when the set is made: the collision masks and
+//       bounding box of each rotation, its wall kicks and its color,
+//       so the board only looks pieces up by number while it plays.
+//       The standard seven come from the Shape classes, other sets
+//       are read from a text file, one piece after another:
+//
+//           # comment
+//           piece NAME COLOR [KICKS [SPAWN]]
+//           .#.
+//           ###
+//
+//       COLOR is a shape color (1-7 or i j l o s t z), KICKS is
+//       jlstz (the default), i, o or none and SPAWN is the SRS state
+//       the drawing is in (0, r, 2 or l, default 0). Blocks are # or X,
+//       anything else is empty, up to SHAPE_MAX_SIZE rows and columns,
+//       and the drawing ends at a blank line. Comments go between pieces.
+//       Each piece turns anticlockwise inside the square around it.
+
+#ifndef TETRIS3_PIECESET_H
+#define TETRIS3_PIECESET_H
+#include "tetris.h"
+#include "Tetromino.h"
+#include "Collision.h"
+#include "KickTable.h"
+#include <cstdint>
+#include <string>
+
+const int PIECE_SET_MAX = 32; // most pieces in a set
+const int PIECE_NAME_MAX = 16;
+
+// blocks of a rotation inside its box
+struct PieceBox{
+    int8_t left;    // first column with a block
+    int8_t top;     // first row with a block
+    int8_t columns; // columns from the first block to the last
+    int8_t rows;    // rows from the first block to the last
+};
+
+struct PieceInfo{
+    char name[PIECE_NAME_MAX];
+    int color;                 // cell color index, see BoardState.h
+    int blocks;
+    PieceBox boxes[4];         // by rotation
+};
+
+class PieceSet {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    PieceSet(); // the standard seven shapes
+
+    // Accessors
+    // --------------------------------------------------------
+    int getCount() const {return _count;}
+    const PieceInfo& getPiece(int piece) const {return _pieces[piece];}
+    const ShapeMask& getMask(int piece, int rotation) const {return _masks[piece][rotation & 3];}
+    const PieceBox& getBox(int piece, int rotation) const {return _pieces[piece].boxes[rotation & 3];}
+    const KickList& getKicks(int piece, int rotation) const {return _kicks[piece][rotation & 3];}
+
+    // Methods
+    // --------------------------------------------------------
+    bool load(const std::string& path);
+    bool addPiece(const char* name, int color, KickStyle kicks, int spawnState,
+                  Tetromino& shape);
+    uint32_t hash() const;
+
+// Private
+// ------------------------------------------------------------
+private:
+    int _count;
+    PieceInfo _pieces[PIECE_SET_MAX];
+    ShapeMask _masks[PIECE_SET_MAX][4];
+    KickList _kicks[PIECE_SET_MAX][4];
+};
+
+const PieceSet& pieceSet();
+
+bool loadPieceSet(const std::string& path);
+
+#endif //TETRIS3_PIECESET_H
@@ -0,0 +1,55 @@
+// File: PreviewQueue.cpp
+//   By: John Holik
+// Desc: Implementation of the shape preview ring
+
+#include "PreviewQueue.h"
+#include "TetrisBoard.h"
+#include <algorithm>
+
+
+// Constructors
+// ------------------------------------------------------------
+
+/**
+ * Default constructor, the start of sequence 0 with the default length
+ */
+PreviewQueue::PreviewQueue() {
+    reset(0, 0, PREVIEW_DEFAULT);
+} // default
+
+
+// Methods
+// ------------------------------------------------------------
+
+/**
+ * Fill the ring from a point in a shape sequence
+ * @param seed - picks the sequence
+ * @param index - sequence index of the front shape
+ * @param length - shapes to look ahead, 1 to PREVIEW_MAX
+ */
+void PreviewQueue::reset(unsigned int seed, unsigned int index, int length) {
+    _seed = seed;
+    _index = index;
+    _length = std::max(1, std::min(length, PREVIEW_MAX));
+    _head = 0;
+
+    for(int ahead = 0; ahead < _length; ++ahead){
+        _shapes[ahead] = int8_t(shapeAt(_seed, _index + unsigned(ahead)));
+    }
+} // reset
+
+
+/**
+ * Take the front shape and draw the next one onto the back
+ * @return piece number of the front shape
+ */
+int PreviewQueue::pop() {
+    int shape = _shapes[_head];
+
+    // the slot after the back, the front's own slot when the ring is full
+    _shapes[(_head + _length) & (PREVIEW_MAX - 1)] = int8_t(shapeAt(_seed, _index + unsigned(_length)));
+    _head = (_head + 1) & (PREVIEW_MAX - 1);
+    ++_index;
+
+    return shape;
+} // pop
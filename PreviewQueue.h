@@ -0,0 +1,57 @@
+// File: PreviewQueue.h
+//   By: John Holik
+// Desc: The next few shapes of a board's shape sequence, kept in a small
+//       ring of piece numbers. The ring is filled ahead of time, so
+//       spawning a shape just takes the front of the ring and draws one
+//       more shape onto the back. The preview panel and the bot read
+//       the shapes coming up from it. Shape n of the sequence is a hash
+//       of the seed and n (see shapeAt() in TetrisBoard.h), so the
+//       whole ring can be rebuilt from the seed and the front's index.
+
+#ifndef TETRIS3_PREVIEWQUEUE_H
+#define TETRIS3_PREVIEWQUEUE_H
+#include "tetris.h"
+#include <cstdint>
+
+const int PREVIEW_MAX = 8;     // most shapes shown ahead, a power of 2
+const int PREVIEW_DEFAULT = 1; // just the next shape
+
+// the preview panel right of the board, each shape at half block size
+const int PREVIEW_WIDTH = 4 * BLOCK_SIZE;
+const int PREVIEW_SLOT_HEIGHT = 3 * BLOCK_SIZE;
+
+
+class PreviewQueue {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    PreviewQueue();
+
+    // Accessors
+    // --------------------------------------------------------
+    int getLength() const {return _length;}
+
+    // sequence index of the front shape
+    unsigned int getIndex() const {return _index;}
+
+    // shape 'ahead' places after the front, 0 .. getLength() - 1
+    int peek(int ahead) const {return _shapes[(_head + ahead) & (PREVIEW_MAX - 1)];}
+
+    // Methods
+    // --------------------------------------------------------
+    void reset(unsigned int seed, unsigned int index, int length);
+    int pop();
+
+// Private
+// ------------------------------------------------------------
+private:
+    int8_t _shapes[PREVIEW_MAX]; // piece numbers, the front at _head
+    int _head;
+    int _length;                 // shapes in the ring, 1 .. PREVIEW_MAX
+
+    unsigned int _seed;          // picks the sequence
+    unsigned int _index;         // sequence index of the front shape
+};
+
+
+#endif //TETRIS3_PREVIEWQUEUE_H
@@ -0,0 +1,281 @@
+// File: ReplayArchive.cpp
+//   By: John Holik
+// Desc: Implementation of the replay archive writer and reader
+
+#include "ReplayArchive.h"
+#include "GameInput.h"
+#include "PieceSet.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// Writer
+// ------------------------------------------------------------
+
+/**
+ * Default constructor, call open() to start an archive
+ */
+ReplayWriter::ReplayWriter() : _file{nullptr}, _startLevel{0} { }
+
+/**
+ * Destructor finishes the archive if it is still open
+ */
+ReplayWriter::~ReplayWriter() {
+    close();
+}
+
+/**
+ * Open an archive to add games to. An archive already at the path keeps
+ * its games, any other file there is replaced.
+ * @param path - archive file
+ * @param startLevel - gravity level every game starts at, 0 for fixed timing
+ * @return false if the file could not be created, or is an archive of
+ *         another version, start level or piece set
+ */
+bool ReplayWriter::open(const std::string& path, int startLevel) {
+    close();
+    _startLevel = startLevel;
+
+    _file = std::fopen(path.c_str(), "r+b");
+    ReplayHeader header{};
+    if(_file && std::fread(&header, sizeof(header), 1, _file) == 1 && header.magic == REPLAY_MAGIC){
+        bool valid = header.version == REPLAY_VERSION &&
+                     header.keyframeFrames == uint32_t(REPLAY_KEYFRAME_FRAMES) &&
+                     header.startLevel == uint32_t(startLevel) &&
+                     header.pieceSet == pieceSet().hash();
+
+        _index.resize(valid ? header.games : 0);
+        valid = valid && std::fseek(_file, long(header.indexOffset), SEEK_SET) == 0 &&
+                std::fread(_index.data(), sizeof(ReplayGame), _index.size(), _file) == _index.size();
+
+        // new games go over the old index, close() writes it after them
+        if(!valid || std::fseek(_file, long(header.indexOffset), SEEK_SET) != 0){
+            std::fclose(_file);
+            _file = nullptr;
+            _index.clear();
+        }
+        return _file != nullptr;
+    }
+    if(_file){
+        std::fclose(_file);
+    }
+
+    _file = std::fopen(path.c_str(), "wb");
+    if(_file){
+        // header is written again with the index offset by close()
+        header = {REPLAY_MAGIC, REPLAY_VERSION, 0, REPLAY_KEYFRAME_FRAMES, 0, 0, 0};
+        std::fwrite(&header, sizeof(header), 1, _file);
+    }
+    return _file != nullptr;
+} // open
+
+/**
+ * Finish the game being recorded, write the index and close the file
+ */
+void ReplayWriter::close() {
+    if(!_file){
+        return;
+    }
+    endGame();
+
+    ReplayHeader header{REPLAY_MAGIC, REPLAY_VERSION, uint32_t(_index.size()),
+                        REPLAY_KEYFRAME_FRAMES, uint64_t(std::ftell(_file)), uint32_t(_startLevel),
+                        pieceSet().hash()};
+    std::fwrite(_index.data(), sizeof(ReplayGame), _index.size(), _file);
+
+    std::fseek(_file, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, _file);
+    std::fclose(_file);
+
+    _file = nullptr;
+    _index.clear();
+} // close
+
+/**
+ * Record the frame about to be updated, call just before board.Update()
+ * @param board - board being recorded
+ * @param input - key states about to be passed to Update()
+ */
+void ReplayWriter::recordFrame(TetrisBoard& board, const KeyPressedState input[]) {
+    if(!_file){
+        return;
+    }
+    if(_keys.size() % REPLAY_KEYFRAME_FRAMES == 0){
+        _keyframes.emplace_back();
+        board.getState(_keyframes.back());
+    }
+    _keys.push_back(uint8_t(packKeys(input)));
+} // recordFrame
+
+/**
+ * Write the recorded game to the archive, the next frame starts a new game
+ */
+void ReplayWriter::endGame() {
+    if(!_file || _keys.empty()){
+        return;
+    }
+
+    ReplayGame game{};
+    game.frames = uint32_t(_keys.size());
+    game.keyframes = uint32_t(_keyframes.size());
+
+    game.keysOffset = uint64_t(std::ftell(_file));
+    std::fwrite(_keys.data(), 1, _keys.size(), _file);
+
+    // keep the keyframes aligned for reading straight from the mapping
+    long padding = (alignof(BoardState) - std::ftell(_file) % alignof(BoardState)) % alignof(BoardState);
+    for(long byte = 0; byte < padding; ++byte){
+        std::fputc(0, _file);
+    }
+
+    game.keyframesOffset = uint64_t(std::ftell(_file));
+    std::fwrite(_keyframes.data(), sizeof(BoardState), _keyframes.size(), _file);
+
+    _index.push_back(game);
+    _keys.clear();
+    _keyframes.clear();
+} // endGame
+
+
+// Reader
+// ------------------------------------------------------------
+
+/**
+ * Default constructor, call open() to read an archive
+ */
+ReplayArchive::ReplayArchive()
+        : _data{nullptr}, _size{0}, _header{nullptr}, _index{nullptr} { }
+
+/**
+ * Destructor unmaps the archive
+ */
+ReplayArchive::~ReplayArchive() {
+    close();
+}
+
+/**
+ * Map an archive into memory and check its header and index
+ * @param path - archive file
+ * @return false if the file can't be read or is not an archive
+ */
+bool ReplayArchive::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+
+    struct stat info{};
+    if(fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(ReplayHeader)){
+        void* data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data != MAP_FAILED){
+            _data = static_cast<const uint8_t*>(data);
+            _size = size_t(info.st_size);
+        }
+    }
+    ::close(fd); // the mapping stays valid
+
+    if(!_data){
+        return false;
+    }
+
+    _header = reinterpret_cast<const ReplayHeader*>(_data);
+    bool valid = _header->magic == REPLAY_MAGIC &&
+                 _header->version == REPLAY_VERSION &&
+                 _header->keyframeFrames > 0 &&
+                 _header->indexOffset + uint64_t(_header->games) * sizeof(ReplayGame) <= _size;
+
+    for(uint32_t game = 0; valid && game < _header->games; ++game){
+        const ReplayGame& entry = reinterpret_cast<const ReplayGame*>(_data + _header->indexOffset)[game];
+        valid = entry.keysOffset + entry.frames <= _size &&
+                entry.keyframesOffset + uint64_t(entry.keyframes) * sizeof(BoardState) <= _size &&
+                entry.keyframes == (entry.frames + _header->keyframeFrames - 1) / _header->keyframeFrames;
+    }
+
+    if(!valid){
+        close();
+        return false;
+    }
+    _index = reinterpret_cast<const ReplayGame*>(_data + _header->indexOffset);
+    return true;
+} // open
+
+/**
+ * Unmap the archive
+ */
+void ReplayArchive::close() {
+    if(_data){
+        munmap(const_cast<uint8_t*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+    _header = nullptr;
+    _index = nullptr;
+} // close
+
+/**
+ * @param game - game in the archive
+ * @return number of update frames recorded for the game
+ */
+int ReplayArchive::getFrames(int game) {
+    return game >= 0 && game < getGames() ? int(_index[game].frames) : 0;
+} // getFrames
+
+/**
+ * Put a board in the state it had just before a recorded frame
+ * @param game - game in the archive
+ * @param frame - frame to jump to (getFrames() for the end of the game)
+ * @param board - board to update
+ * @param input - key states, set to those of the frame
+ * @return false if the game or frame is not in the archive
+ */
+bool ReplayArchive::seek(int game, int frame, TetrisBoard& board, KeyPressedState input[]) {
+    if(game < 0 || game >= getGames() || frame < 0 || frame > getFrames(game)){
+        return false;
+    }
+    const ReplayGame& entry = _index[game];
+
+    // start from the nearest keyframe at or before the frame
+    uint32_t keyframe = std::min(uint32_t(frame) / _header->keyframeFrames, entry.keyframes - 1);
+    const auto* keyframes = reinterpret_cast<const BoardState*>(_data + entry.keyframesOffset);
+    board.setState(keyframes[keyframe]);
+
+    const uint8_t* keys = _data + entry.keysOffset;
+    for(uint32_t replay = keyframe * _header->keyframeFrames; replay < uint32_t(frame); ++replay){
+        unpackKeys(keys[replay], input);
+        board.Update(input);
+    }
+
+    if(uint32_t(frame) < entry.frames){
+        unpackKeys(keys[frame], input);
+    }
+    return true;
+} // seek
+
+/**
+ * Play one recorded frame on a board already in the state before it,
+ * for normal playback instead of a seek() every frame
+ * @param game - game in the archive
+ * @param frame - frame to play
+ * @param board - board to update
+ * @param input - key states, set to those of the frame after
+ * @return false if the game or frame is not in the archive
+ */
+bool ReplayArchive::step(int game, int frame, TetrisBoard& board, KeyPressedState input[]) {
+    if(game < 0 || game >= getGames() || frame < 0 || frame >= getFrames(game)){
+        return false;
+    }
+    const uint8_t* keys = _data + _index[game].keysOffset;
+
+    unpackKeys(keys[frame], input);
+    board.Update(input);
+
+    if(frame + 1 < getFrames(game)){
+        unpackKeys(keys[frame + 1], input);
+    }
+    return true;
+} // step
@@ -0,0 +1,110 @@
+// File: ReplayArchive.h
+//   By: John Holik
+// Desc: On-disk archive of recorded games. Every game stores the packed
+//       game keys of each update frame plus a full BoardState keyframe
+//       every REPLAY_KEYFRAME_FRAMES frames. An index at the end of the
+//       file, found through the header, locates each game. The reader
+//       maps the file into memory, so jumping to any game and frame costs
+//       one keyframe restore and at most REPLAY_KEYFRAME_FRAMES updates.
+//
+//       file: [header][game 0 keys][game 0 keyframes]...[index]
+//
+//       Recording to an existing archive adds the new games after the
+//       ones already in it, writing the index again after them.
+
+#ifndef TETRIS3_REPLAYARCHIVE_H
+#define TETRIS3_REPLAYARCHIVE_H
+#include "tetris.h"
+#include "TetrisBoard.h"
+#include "BoardState.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+const uint32_t REPLAY_MAGIC = 0x41525454; // "TTRA"
+// 2: hashed shape sequence, 3: SRS kicks, 4: start level, 5: piece set hash
+const uint32_t REPLAY_VERSION = 5;
+const int REPLAY_KEYFRAME_FRAMES = FPS * 4; // frames between keyframes
+
+struct ReplayHeader{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t games;
+    uint32_t keyframeFrames;  // REPLAY_KEYFRAME_FRAMES when written
+    uint64_t indexOffset;     // file offset of the ReplayGame index
+    uint32_t startLevel;      // gravity level every game starts at, 0 for fixed timing
+    uint32_t pieceSet;        // PieceSet::hash() of the set played with
+};
+
+struct ReplayGame{
+    uint64_t keysOffset;      // one byte of packKeys() per frame
+    uint64_t keyframesOffset; // BoardState before frame 0, N, 2N, ...
+    uint32_t frames;
+    uint32_t keyframes;
+};
+
+
+class ReplayWriter {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    ReplayWriter();
+
+    ~ReplayWriter(); // destructor, closes the archive
+
+    // Accessors
+    // --------------------------------------------------------
+    bool isOpen() {return _file != nullptr;}
+
+    // Methods
+    // --------------------------------------------------------
+    bool open(const std::string& path, int startLevel);
+    void close();
+
+    void recordFrame(TetrisBoard& board, const KeyPressedState input[]);
+    void endGame();
+
+private:
+    std::FILE* _file;
+    std::vector<ReplayGame> _index;
+    int _startLevel;       // gravity level of every game in the archive
+
+    // game being recorded
+    std::vector<uint8_t> _keys;
+    std::vector<BoardState> _keyframes;
+};
+
+
+class ReplayArchive {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    ReplayArchive();
+
+    ~ReplayArchive(); // destructor, unmaps the archive
+
+    // Accessors
+    // --------------------------------------------------------
+    int getGames() {return _header ? int(_header->games) : 0;}
+    int getStartLevel() {return _header ? int(_header->startLevel) : 0;}
+    uint32_t getPieceSet() {return _header ? _header->pieceSet : 0;}
+    int getFrames(int game);
+
+    // Methods
+    // --------------------------------------------------------
+    bool open(const std::string& path);
+    void close();
+
+    bool seek(int game, int frame, TetrisBoard& board, KeyPressedState input[]);
+    bool step(int game, int frame, TetrisBoard& board, KeyPressedState input[]);
+
+private:
+    const uint8_t* _data;  // mapped file
+    size_t _size;
+    const ReplayHeader* _header;
+    const ReplayGame* _index;
+};
+
+
+#endif //TETRIS3_REPLAYARCHIVE_H
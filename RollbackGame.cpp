@@ -0,0 +1,238 @@
+// File: RollbackGame.cpp
+//   By: John Holik
+// Desc: Implementation of the rollback versus game
+
+#include "RollbackGame.h"
+#include "VersusGame.h"
+#include "GameInput.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+const uint32_t NO_TICK = 0xFFFFFFFFu;
+
+// local functions
+static int garbageHole(unsigned int seed, uint32_t tick, int from);
+
+
+/**
+ * Property constructor, both sides must use the same seed
+ * @param localPlayer - board played here, 0 or 1
+ * @param seed - shape sequence of both boards and the garbage holes
+ * @param link - open link to the other side
+ */
+RollbackGame::RollbackGame(int localPlayer, unsigned int seed, LagLink& link)
+        : _local{localPlayer}, _remote{1 - localPlayer}, _seed{seed}, _link{link},
+          _history{SnapshotRing(ROLLBACK_HISTORY), SnapshotRing(ROLLBACK_HISTORY)},
+          _tick{0}, _remoteConfirmed{0}, _remoteAck{0}, _rollbackFrom{0},
+          _pendingInput{INPUT_NONE}, _finished{false},
+          _rollbacks{0}, _resimulated{0}, _stalls{0} {
+
+    for(int player = 0; player < ROLLBACK_PLAYERS; ++player){
+        _boards[player] = new TetrisBoard(seed);
+        _keys[player].assign(sf::Keyboard::KeyCount, KeyPressedState{false, false});
+    }
+    for(uint32_t& tick : _remoteTicks){
+        tick = NO_TICK;
+    }
+    std::memset(_inputs, 0, sizeof(_inputs));
+    std::memset(_keyHistory, 0, sizeof(_keyHistory));
+} // property
+
+/**
+ * Destructor cleans up the boards
+ */
+RollbackGame::~RollbackGame() {
+    for(TetrisBoard* board : _boards){
+        delete board;
+    }
+}
+
+/**
+ * Run one frame: take in the remote inputs that arrived, correct any
+ * wrong predictions and run the next tick with the local input
+ * @param localInput - InputBits pressed locally this frame
+ * @return true once the game is over on confirmed inputs
+ */
+bool RollbackGame::Update(unsigned int localInput) {
+    _pendingInput |= localInput;
+
+    receiveInputs();
+    rollback();
+
+    // a game over is only final once no prediction can change it, until
+    // then hold on the tick it happened
+    bool over = _boards[0]->isGameOver() || _boards[1]->isGameOver();
+    _finished = over && _tick <= _remoteConfirmed;
+
+    // too far past the remote input to predict any further, wait for it
+    if(over || _tick >= _remoteConfirmed + ROLLBACK_MAX_FRAMES){
+        if(!over){
+            ++_stalls;
+        }
+        sendInputs();
+        return _finished;
+    }
+
+    _inputs[_tick % ROLLBACK_HISTORY][_local] = uint8_t(_pendingInput);
+    _pendingInput = INPUT_NONE;
+
+    simulate(_tick);
+    ++_tick;
+    _rollbackFrom = _tick;
+
+    sendInputs();
+
+    over = _boards[0]->isGameOver() || _boards[1]->isGameOver();
+    _finished = over && _tick <= _remoteConfirmed;
+    return _finished;
+} // Update
+
+/**
+ * Draw both boards side by side, the local board on the left
+ * @param window - game window
+ */
+void RollbackGame::render(sf::RenderWindow& window) {
+    sf::View view{sf::FloatRect(0.f, 0.f, WIN_WIDTH, WIN_HEIGHT)};
+
+    int players[ROLLBACK_PLAYERS] = {_local, _remote};
+    for(int side = 0; side < ROLLBACK_PLAYERS; ++side){
+        view.setViewport(sf::FloatRect(float(side) / ROLLBACK_PLAYERS, 0.f,
+                                       1.f / ROLLBACK_PLAYERS, 1.f));
+        window.setView(view);
+        _boards[players[side]]->render(window);
+    }
+
+    window.setView(window.getDefaultView());
+} // render
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * Read every packet that arrived, noting the first tick that was run
+ * with a prediction the real input doesn't match
+ */
+void RollbackGame::receiveInputs() {
+    InputPacket packet;
+    int size;
+    while((size = _link.receive(&packet, sizeof(packet))) > 0){
+        if(size < int(offsetof(InputPacket, inputs)) || packet.count > ROLLBACK_SEND_INPUTS ||
+           size < int(offsetof(InputPacket, inputs)) + packet.count){
+            continue; // not one of ours
+        }
+        _remoteAck = std::max(_remoteAck, packet.ackTick);
+
+        for(int index = 0; index < packet.count; ++index){
+            uint32_t tick = packet.firstTick + uint32_t(index);
+            int slot = int(tick % ROLLBACK_HISTORY);
+            if(tick < _remoteConfirmed || _remoteTicks[slot] == tick ||
+               tick >= _remoteConfirmed + ROLLBACK_HISTORY){
+                continue; // already have it, or too far ahead to keep
+            }
+
+            _remoteTicks[slot] = tick;
+            _remoteInputs[slot] = packet.inputs[index];
+            if(tick < _tick && _inputs[slot][_remote] != packet.inputs[index]){
+                _rollbackFrom = std::min(_rollbackFrom, tick);
+            }
+        }
+    }
+
+    while(_remoteTicks[_remoteConfirmed % ROLLBACK_HISTORY] == _remoteConfirmed){
+        ++_remoteConfirmed;
+    }
+} // receiveInputs
+
+/**
+ * Send the local inputs the remote may not have yet
+ */
+void RollbackGame::sendInputs() {
+    uint32_t first = std::max(_remoteAck, _tick > uint32_t(ROLLBACK_SEND_INPUTS) ?
+                                          _tick - ROLLBACK_SEND_INPUTS : 0u);
+
+    InputPacket packet{};
+    packet.firstTick = first;
+    packet.ackTick = _remoteConfirmed;
+    packet.count = uint8_t(_tick - first);
+    for(int index = 0; index < packet.count; ++index){
+        packet.inputs[index] = _inputs[(first + index) % ROLLBACK_HISTORY][_local];
+    }
+
+    _link.send(&packet, int(offsetof(InputPacket, inputs)) + packet.count);
+} // sendInputs
+
+/**
+ * Go back to the first mispredicted tick and run every tick since again
+ */
+void RollbackGame::rollback() {
+    if(_rollbackFrom >= _tick){
+        return;
+    }
+
+    uint32_t from = _rollbackFrom;
+    for(int player = 0; player < ROLLBACK_PLAYERS; ++player){
+        _history[player].rewind(from, *_boards[player]);
+        unpackKeys(_keyHistory[from % ROLLBACK_HISTORY][player], _keys[player].data());
+    }
+
+    for(uint32_t tick = from; tick < _tick; ++tick){
+        simulate(tick);
+    }
+
+    ++_rollbacks;
+    _resimulated += int(_tick - from);
+    _rollbackFrom = _tick;
+} // rollback
+
+/**
+ * Save the state before a tick, then run it on both boards and
+ * exchange garbage
+ * @param tick - tick to run, its local input must be set
+ */
+void RollbackGame::simulate(uint32_t tick) {
+    int slot = int(tick % ROLLBACK_HISTORY);
+
+    for(int player = 0; player < ROLLBACK_PLAYERS; ++player){
+        _history[player].record(tick, *_boards[player]);
+        _keyHistory[slot][player] = uint8_t(packKeys(_keys[player].data()));
+    }
+
+    // the real remote input if it is here, otherwise predict no keys
+    _inputs[slot][_remote] = _remoteTicks[slot] == tick ? _remoteInputs[slot] : uint8_t(INPUT_NONE);
+
+    bool finished[ROLLBACK_PLAYERS];
+    for(int player = 0; player < ROLLBACK_PLAYERS; ++player){
+        pressInputs(_inputs[slot][player], _keys[player].data());
+        finished[player] = _boards[player]->Update(_keys[player].data());
+    }
+
+    // same garbage rules as VersusGame, with holes that depend only on
+    // the tick so both sides agree
+    for(int player = 0; player < ROLLBACK_PLAYERS; ++player){
+        int other = 1 - player;
+        int rows = GARBAGE_FOR_LINES[std::min(_boards[player]->getLastCleared(), 4)];
+        if(rows > 0 && !finished[player] && !finished[other]){
+            _boards[other]->addGarbage(rows, garbageHole(_seed, tick, player));
+        }
+    }
+} // simulate
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * @param seed - game seed
+ * @param tick - tick the garbage is sent
+ * @param from - player sending it
+ * @return open column of the garbage rows
+ */
+static int garbageHole(unsigned int seed, uint32_t tick, int from) {
+    uint32_t bits = seed ^ (tick * 2654435761u) ^ (uint32_t(from) * 40503u);
+    bits ^= bits >> 16;
+    bits *= 0x45D9F3Bu;
+    bits ^= bits >> 16;
+    return int(bits % GAME_COLUMNS);
+}
@@ -0,0 +1,101 @@
+// File: RollbackGame.h
+//   By: John Holik
+// Desc: Two player versus game kept in sync over a LagLink with
+//       rollback. Each side runs both boards. The local input is used
+//       right away and the remote input is predicted (no keys pressed)
+//       until it arrives. When an input turns out to differ from the
+//       prediction, both boards are put back to the snapshot taken
+//       before that tick and the ticks since are run again with the
+//       real input. The game never runs more than ROLLBACK_MAX_FRAMES
+//       ahead of the last input received, so a rollback re-runs at most
+//       that many ticks.
+
+#ifndef TETRIS3_ROLLBACKGAME_H
+#define TETRIS3_ROLLBACKGAME_H
+#include "tetris.h"
+#include "TetrisBoard.h"
+#include "SnapshotRing.h"
+#include "LagLink.h"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+const int ROLLBACK_MAX_FRAMES = 8;    // ticks the game may run past the remote input
+const int ROLLBACK_HISTORY = 64;      // ticks of snapshots and inputs kept
+const int ROLLBACK_SEND_INPUTS = 32;  // unacknowledged inputs repeated in every packet
+const int ROLLBACK_PLAYERS = 2;
+
+struct InputPacket{
+    uint32_t firstTick;                    // tick of inputs[0]
+    uint32_t ackTick;                      // sender has the receiver's inputs before this tick
+    uint8_t count;
+    uint8_t inputs[ROLLBACK_SEND_INPUTS];  // InputBits per tick
+};
+
+
+class RollbackGame {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    RollbackGame(int localPlayer, unsigned int seed, LagLink& link);
+
+    ~RollbackGame(); // destructor
+
+    RollbackGame(const RollbackGame& other) = delete;
+    RollbackGame& operator=(const RollbackGame& rhs) = delete;
+
+    // Accessors
+    // --------------------------------------------------------
+    uint32_t getTick() {return _tick;}
+    uint32_t getConfirmedTick() {return _remoteConfirmed;}
+    int getRollbacks() {return _rollbacks;}
+    int getResimulated() {return _resimulated;}
+    int getStalls() {return _stalls;}
+    bool isFinished() {return _finished;}
+    sf::Vector2u getWindowSize() {return {unsigned(WIN_WIDTH * ROLLBACK_PLAYERS), unsigned(WIN_HEIGHT)};}
+
+    void getState(int player, BoardState& state) {_boards[player]->getState(state);}
+
+    // Methods
+    // --------------------------------------------------------
+    bool Update(unsigned int localInput);
+
+    void render(sf::RenderWindow& window);
+
+private:
+    int _local;
+    int _remote;
+    unsigned int _seed;
+    LagLink& _link;
+
+    TetrisBoard* _boards[ROLLBACK_PLAYERS];
+    std::vector<KeyPressedState> _keys[ROLLBACK_PLAYERS];
+
+    // state before each tick, slot tick % ROLLBACK_HISTORY
+    SnapshotRing _history[ROLLBACK_PLAYERS];
+    uint8_t _keyHistory[ROLLBACK_HISTORY][ROLLBACK_PLAYERS];  // packKeys()
+    uint8_t _inputs[ROLLBACK_HISTORY][ROLLBACK_PLAYERS];      // input each tick was run with
+
+    // remote inputs received, slot tick % ROLLBACK_HISTORY
+    uint32_t _remoteTicks[ROLLBACK_HISTORY];  // tick of the input in the slot
+    uint8_t _remoteInputs[ROLLBACK_HISTORY];
+
+    uint32_t _tick;             // next tick to run
+    uint32_t _remoteConfirmed;  // every remote input before this tick has arrived
+    uint32_t _remoteAck;        // the remote has our inputs before this tick
+    uint32_t _rollbackFrom;     // first tick run with a wrong prediction
+    unsigned int _pendingInput; // local input held while stalled
+    bool _finished;             // game over on confirmed input
+
+    int _rollbacks;
+    int _resimulated;
+    int _stalls;
+
+    void receiveInputs();
+    void sendInputs();
+    void rollback();
+    void simulate(uint32_t tick);
+};
+
+
+#endif //TETRIS3_ROLLBACKGAME_H
@@ -0,0 +1,171 @@
+// File: RolloutEvaluator.cpp
+//   By: John Holik
+// Desc: Implementation of the Monte Carlo rollout evaluator
+
+#include "RolloutEvaluator.h"
+#include "Arena.h"
+#include "BatchEvaluator.h"
+#include "PieceSet.h"
+#include <random>
+
+// score given to a rollout that topped out
+const float ROLLOUT_TOPPED_OUT = -1000.f;
+
+// scratch memory of the thread running a rollout batch
+static thread_local Arena rolloutScratch;
+
+// batch results of the evaluate() running on this thread, apart from
+// rolloutScratch since this thread runs batches too while it waits
+static thread_local Arena rolloutResults;
+
+struct BatchResult{
+    double score;
+    long lines;
+    int survived;
+};
+
+
+/**
+ * Property constructor
+ * @param pool - threads to run rollouts on
+ * @param weights - used to score final boards and for the greedy policy
+ */
+RolloutEvaluator::RolloutEvaluator(WorkStealingPool& pool, const EvalWeights& weights)
+        : _pool{pool}, _weights{weights} { }
+
+/**
+ * Average the outcome of many games played on from a board
+ * @param board - starting board, without a current shape
+ * @param next - the first shape to place (the known next shape)
+ * @param rollouts - number of games to play
+ * @param horizon - shapes placed in each game
+ * @param policy - how each shape is placed
+ * @param seed - seed for the shapes, the same seed gives the same result
+ * @return averaged outcome
+ */
+RolloutResult RolloutEvaluator::evaluate(const SearchBoard& board, Tetromino::ShapeType next,
+                                         int rollouts, int horizon, RolloutPolicy policy,
+                                         uint32_t seed) {
+    int batches = (rollouts + ROLLOUT_BATCH - 1) / ROLLOUT_BATCH;
+    rolloutResults.reset();
+    BatchResult* results = rolloutResults.allocate<BatchResult>(batches);
+
+    auto runBatch = [&](int batch) {
+        rolloutScratch.reset();
+
+        int first = batch * ROLLOUT_BATCH;
+        int count = std::min(ROLLOUT_BATCH, rollouts - first);
+
+        Placement* placements = rolloutScratch.allocate<Placement>(MAX_PLACEMENTS);
+        SearchBoard* after = rolloutScratch.allocate<SearchBoard>(MAX_PLACEMENTS);
+        int* cleared = rolloutScratch.allocate<int>(MAX_PLACEMENTS);
+        float* scores = rolloutScratch.allocate<float>(MAX_PLACEMENTS);
+
+        BatchResult result{0.0, 0, 0};
+        for(int rollout = 0; rollout < count; ++rollout){
+            SearchBoard current = board; // each rollout plays on its own copy
+
+            // each rollout has its own generator so results don't depend
+            // on which thread ran the batch
+            std::minstd_rand generator(seed + uint32_t(first + rollout) * 7919u + 1u);
+            std::uniform_int_distribution<> shapes(0, pieceSet().getCount() - 1);
+
+            int lines = 0;
+            bool toppedOut = false;
+            for(int step = 0; step < horizon && !toppedOut; ++step){
+                auto type = step == 0 ? next : Tetromino::ShapeType(shapes(generator));
+
+                int available = current.placements(type, placements);
+                if(available == 0){
+                    toppedOut = true;
+                    break;
+                }
+
+                int chosen = 0;
+                if(policy == ROLLOUT_RANDOM){
+                    chosen = std::uniform_int_distribution<>(0, available - 1)(generator);
+                } else {
+                    // score every placement together
+                    for(int index = 0; index < available; ++index){
+                        after[index] = current;
+                        cleared[index] = after[index].place(shapeMask(type, placements[index].rotation),
+                                                            placements[index].column, placements[index].row);
+                    }
+                    evaluateBoards(after, cleared, available, _weights, scores);
+
+                    for(int index = 1; index < available; ++index){
+                        if(scores[index] > scores[chosen]){
+                            chosen = index;
+                        }
+                    }
+                }
+
+                lines += current.place(shapeMask(type, placements[chosen].rotation),
+                                       placements[chosen].column, placements[chosen].row);
+            } // each shape
+
+            result.lines += lines;
+            if(toppedOut){
+                result.score += ROLLOUT_TOPPED_OUT;
+            } else {
+                result.score += ::evaluate(current, lines, _weights);
+                ++result.survived;
+            }
+        } // each rollout
+
+        results[batch] = result;
+    };
+    _pool.run(batches, runBatch);
+
+    RolloutResult total{0.f, 0.f, 0.f, rollouts};
+    if(rollouts > 0){
+        double score = 0.0;
+        long lines = 0;
+        int survived = 0;
+        for(int batch = 0; batch < batches; ++batch){
+            score += results[batch].score;
+            lines += results[batch].lines;
+            survived += results[batch].survived;
+        }
+        total.score = float(score / rollouts);
+        total.lines = float(lines) / rollouts;
+        total.survival = float(survived) / rollouts;
+    }
+    return total;
+} // evaluate
+
+/**
+ * Pick the placement of the current shape with the best rollout score
+ * @param board - board without the current shape
+ * @param shape - current shape
+ * @param next - next shape, the first shape of every rollout
+ * @param rollouts - games played from each placement
+ * @param horizon - shapes placed in each game
+ * @param policy - how each shape is placed in the rollouts
+ * @param seed - seed for the shapes, shared by every placement so they
+ *               are compared on the same games
+ * @return best placement
+ */
+Placement RolloutEvaluator::choosePlacement(const SearchBoard& board, Tetromino::ShapeType shape,
+                                            Tetromino::ShapeType next, int rollouts, int horizon,
+                                            RolloutPolicy policy, uint32_t seed) {
+    Placement placements[MAX_PLACEMENTS];
+    int count = board.placements(shape, placements);
+
+    Placement best{0, START_CELL_COLUMN, 0, 0, 0, 0};
+    float bestScore = -1e9f;
+    for(int index = 0; index < count; ++index){
+        SearchBoard after = board;
+        int cleared = after.place(shapeMask(shape, placements[index].rotation),
+                                  placements[index].column, placements[index].row);
+
+        // the rollouts only score the lines cleared after this placement
+        RolloutResult result = evaluate(after, next, rollouts, horizon, policy, seed);
+        float score = result.score + _weights.lines * cleared;
+        if(score > bestScore){
+            bestScore = score;
+            best = placements[index];
+        }
+    }
+    return best;
+} // choosePlacement
@@ -0,0 +1,53 @@
+// File: RolloutEvaluator.h
+//   By: John Holik
+// Desc: Monte Carlo evaluation of a board. Many games are played on from
+//       the board for a fixed number of shapes, with random shapes and a
+//       random or greedy placement policy, and their outcomes averaged.
+//       Rollouts are split into batches run on a WorkStealingPool, each
+//       batch keeping its placement lists and scored boards in the
+//       running thread's scratch arena, which is reset for the next batch.
+
+#ifndef TETRIS3_ROLLOUTEVALUATOR_H
+#define TETRIS3_ROLLOUTEVALUATOR_H
+#include "tetris.h"
+#include "SearchBoard.h"
+#include "WorkStealingPool.h"
+#include <cstdint>
+
+const int ROLLOUT_BATCH = 64; // rollouts per pool task
+
+enum RolloutPolicy{
+    ROLLOUT_RANDOM,  // any placement of the shape
+    ROLLOUT_GREEDY   // the best scoring placement of the shape
+};
+
+struct RolloutResult{
+    float score;     // mean score of the final boards, evaluate() with lines
+    float lines;     // mean lines cleared
+    float survival;  // share of rollouts that did not top out
+    int rollouts;
+};
+
+
+class RolloutEvaluator {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    explicit RolloutEvaluator(WorkStealingPool& pool, const EvalWeights& weights = DEFAULT_WEIGHTS);
+
+    // Methods
+    // --------------------------------------------------------
+    RolloutResult evaluate(const SearchBoard& board, Tetromino::ShapeType next,
+                           int rollouts, int horizon, RolloutPolicy policy, uint32_t seed);
+
+    Placement choosePlacement(const SearchBoard& board, Tetromino::ShapeType shape,
+                              Tetromino::ShapeType next, int rollouts, int horizon,
+                              RolloutPolicy policy, uint32_t seed);
+
+private:
+    WorkStealingPool& _pool;
+    EvalWeights _weights;
+};
+
+
+#endif //TETRIS3_ROLLOUTEVALUATOR_H
@@ -0,0 +1,324 @@
+// File: SearchBoard.cpp
+//   By: John Holik
+// Desc: Implementation of the AI search board
+
+#include "SearchBoard.h"
+#include "KickTable.h"
+#include "GameInput.h"
+#include "PieceSet.h"
+#include <algorithm>
+#include <cstdlib>
+
+// local functions
+static bool addPlacement(Placement out[], int& count, uint32_t seen[][COLLISION_OFFSETS],
+                         const Placement& placement);
+static bool insideWalls(const ShapeMask& mask, int offset);
+
+/**
+ * Empty every row
+ */
+void SearchBoard::clear() {
+    for(int row = 0; row < GAME_ROWS; ++row){
+        rows[row] = ROW_EMPTY;
+    }
+} // clear
+
+/**
+ * Copy the filled cells of a board state, the shapes are ignored
+ * @param state - board to copy
+ */
+void SearchBoard::fromState(const BoardState& state) {
+    for(int row = 0; row < GAME_ROWS; ++row){
+        rows[row] = ROW_EMPTY;
+        for(int column = 0; column < GAME_COLUMNS; ++column){
+            if(cellAt(state, row, column) != CELL_EMPTY){
+                rows[row] |= 1u << (column + COLLISION_PAD_LEFT);
+            }
+        }
+    }
+} // fromState
+
+/**
+ * Find where a shape lands if dropped straight down
+ * @param mask - shape to drop
+ * @param column - grid column of the shape's left side
+ * @param row - grid row to drop from, must not collide
+ * @return lowest row the shape can reach
+ */
+int SearchBoard::dropRow(const ShapeMask& mask, int column, int row) const {
+    while(!hasCollision(rows, mask, column, row - 1)){
+        --row;
+    }
+    return row;
+} // dropRow
+
+/**
+ * Lock a shape into the board and remove any full rows
+ * @param mask - shape to lock
+ * @param column - grid column of the shape's left side
+ * @param row - grid row of the shape's top row
+ * @return number of rows cleared
+ */
+int SearchBoard::place(const ShapeMask& mask, int column, int row) {
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        int gridRow = row - shapeRow;
+        if(gridRow >= 0 && gridRow < GAME_ROWS){
+            rows[gridRow] |= mask.shifted[shapeRow][column + COLLISION_PAD_LEFT];
+        }
+    }
+
+    int cleared = 0;
+    for(int gridRow = 0; gridRow < GAME_ROWS; ++gridRow){
+        if((rows[gridRow] & ROW_BOARD_BITS) == ROW_BOARD_BITS){
+            ++cleared;
+        } else if(cleared > 0){
+            rows[gridRow - cleared] = rows[gridRow];
+        }
+    }
+    for(int gridRow = GAME_ROWS - cleared; gridRow < GAME_ROWS; ++gridRow){
+        rows[gridRow] = ROW_EMPTY;
+    }
+    return cleared;
+} // place
+
+/**
+ * List every place a new shape can be dropped to. Like a player, the
+ * shape is rotated at the starting cell (wall kicks included), moved
+ * sideways along the free columns of that row and then dropped. Then
+ * from every row each of those drops falls through beside the stack,
+ * the shape is moved one column or turned with its wall kicks and
+ * dropped again, which finds the tucks under overhangs and the spins
+ * into slots. A shape locks as soon as it lands, so these moves are
+ * made while it can still fall.
+ * @param type - shape to place
+ * @param out - receives the placements, MAX_PLACEMENTS long
+ * @return number of placements
+ */
+int SearchBoard::placements(Tetromino::ShapeType type, Placement out[]) const {
+    int count = 0;
+    int startColumn = START_CELL_COLUMN;
+    int startRow = START_CELL_ROW;
+    int startRows[4] = {0}; // starting row of each rotation
+
+    // rows of each rotation and column already placed at, by bit
+    uint32_t seen[4][COLLISION_OFFSETS] = {};
+
+    // row a straight drop lands at, by rotation and column offset, a
+    // move ending at or above it just drops there too. Offsets no drop
+    // reached could be under the stack, unless they are in a wall.
+    int landing[4][COLLISION_OFFSETS];
+    for(int rotation = 0; rotation < 4; ++rotation){
+        const ShapeMask& mask = shapeMask(type, rotation);
+        for(int offset = 0; offset < COLLISION_OFFSETS; ++offset){
+            landing[rotation][offset] = insideWalls(mask, offset) ? -1 : GAME_ROWS + SHAPE_MAX_SIZE;
+        }
+    }
+
+    for(int rotation = 0; rotation < 4; ++rotation){
+        const ShapeMask& mask = shapeMask(type, rotation);
+
+        // each rotation turns the last one where it is, kicking if needed
+        if(rotation == 0){
+            if(hasCollision(rows, mask, startColumn, startRow)){
+                break;
+            }
+        } else{
+            int kick = findKick(rows, type, rotation - 1, startColumn, startRow);
+            if(kick < 0){
+                break;
+            }
+            const Kick& offset = rotationKicks(type, rotation - 1).kicks[kick];
+            startColumn += offset.column;
+            startRow += offset.row;
+        }
+
+        unsigned int legal = legalColumns(rows, mask, startRow);
+
+        // free columns connected to the starting column
+        int left = startColumn;
+        while(isLegalColumn(legal, left - 1)){
+            --left;
+        }
+        int right = startColumn;
+        while(isLegalColumn(legal, right + 1)){
+            ++right;
+        }
+
+        for(int column = left; column <= right; ++column){
+            int row = dropRow(mask, column, startRow);
+            landing[rotation][column + COLLISION_PAD_LEFT] = row;
+            addPlacement(out, count, seen, {int8_t(rotation), int8_t(column), int8_t(row), INPUT_NONE, 0, 0});
+        }
+        startRows[rotation] = startRow;
+    } // each rotation
+
+    // a move only reaches somewhere new next to the stack, with a kick
+    // moving the shape down up to two rows
+    int stackTop = GAME_ROWS - 1;
+    while(stackTop >= 0 && (rows[stackTop] & ROW_BOARD_BITS) == 0){
+        --stackTop;
+    }
+
+    int drops = count;
+    for(int drop = 0; drop < drops; ++drop){
+        const Placement& from = out[drop];
+        int rotation = from.rotation;
+        int column = from.column;
+        int top = std::min(startRows[rotation], stackTop + SHAPE_MAX_SIZE + 1);
+        const ShapeMask& mask = shapeMask(type, rotation);
+
+        // one column over, only below where a drop in that column lands
+        for(int side = -1; side <= 1; side += 2){
+            int offset = column + side + COLLISION_PAD_LEFT;
+            int last = offset >= 0 && offset < COLLISION_OFFSETS ? std::min(top, landing[rotation][offset] - 1) : -1;
+
+            for(int row = from.row + 1; row <= last; ++row){
+                if(!hasCollision(rows, mask, column + side, row)){
+                    addPlacement(out, count, seen, {int8_t(rotation), int8_t(column + side),
+                                                    int8_t(dropRow(mask, column + side, row)),
+                                                    int8_t(side < 0 ? INPUT_LEFT : INPUT_RIGHT),
+                                                    int8_t(column), int8_t(row)});
+                }
+            }
+        } // each side
+
+        // turned, only where a kick can end below a straight drop
+        int turnedRotation = (rotation + 1) % 4;
+        const ShapeMask& turned = shapeMask(type, turnedRotation);
+        const KickList& kicks = rotationKicks(type, rotation);
+        int emptyTop = pieceSet().getBox(type, turnedRotation).top;
+
+        int last = -1;
+        for(int test = 0; test < kicks.count; ++test){
+            int offset = column + kicks.kicks[test].column + COLLISION_PAD_LEFT;
+            if(offset >= 0 && offset < COLLISION_OFFSETS){
+                last = std::max(last, landing[turnedRotation][offset] - kicks.kicks[test].row - 1);
+            }
+        }
+        last = std::min(top, last);
+
+        const Kick& first = kicks.kicks[0];
+        int firstOffset = column + first.column + COLLISION_PAD_LEFT;
+        for(int row = from.row + 1; row <= last; ++row){
+            // the first kick fitting where a straight drop passes through
+            // just drops there again
+            int firstRow = row + first.row;
+            if(firstOffset >= 0 && firstOffset < COLLISION_OFFSETS &&
+               firstRow >= landing[turnedRotation][firstOffset] && firstRow - emptyTop < GAME_ROWS &&
+               !hasCollision(rows, turned, column + first.column, firstRow)){
+                continue;
+            }
+
+            int kick = findKick(rows, type, rotation, column, row);
+            if(kick >= 0){
+                int kickColumn = column + kicks.kicks[kick].column;
+                addPlacement(out, count, seen, {int8_t(turnedRotation), int8_t(kickColumn),
+                                                int8_t(dropRow(turned, kickColumn, row + kicks.kicks[kick].row)),
+                                                int8_t(INPUT_ROTATE), int8_t(column), int8_t(row)});
+            }
+        } // each row the drop falls through
+    } // each straight drop
+
+    return count;
+} // placements
+
+/**
+ * Fill in how to reach a placement found by placements(), such as one
+ * kept in the transposition table with just its position
+ * @param type - shape placed
+ * @param placement - rotation, column and row to find, receives the move
+ * @return false if the shape can't reach it on this board
+ */
+bool SearchBoard::route(Tetromino::ShapeType type, Placement& placement) const {
+    Placement found[MAX_PLACEMENTS];
+    int count = placements(type, found);
+
+    for(int index = 0; index < count; ++index){
+        if(found[index].rotation == placement.rotation && found[index].column == placement.column &&
+           found[index].row == placement.row){
+            placement = found[index];
+            return true;
+        }
+    }
+    return false;
+} // route
+
+
+/**
+ * Score a board with a weighted sum of its features, higher is better
+ * @param board - board after a placement
+ * @param lines - rows the placement cleared
+ * @param weights - weight of each feature
+ * @return score of the board
+ */
+float evaluate(const SearchBoard& board, int lines, const EvalWeights& weights) {
+    int heights[GAME_COLUMNS] = {0};
+    int holes = 0;
+
+    // walk down from the top, a column's height is its first filled cell
+    // and every empty cell below that is a hole
+    uint32_t covered = 0;
+    for(int row = GAME_ROWS - 1; row >= 0; --row){
+        uint32_t filled = board.rows[row] & ROW_BOARD_BITS;
+        uint32_t top = filled & ~covered;
+
+        while(top){
+            int column = __builtin_ctz(top) - COLLISION_PAD_LEFT;
+            heights[column] = row + 1;
+            top &= top - 1;
+        }
+        holes += __builtin_popcount(covered & ~filled);
+        covered |= filled;
+    }
+
+    int height = 0;
+    int bumpiness = 0;
+    for(int column = 0; column < GAME_COLUMNS; ++column){
+        height += heights[column];
+        if(column > 0){
+            bumpiness += std::abs(heights[column] - heights[column - 1]);
+        }
+    }
+
+    return weights.height * height + weights.lines * lines +
+           weights.holes * holes + weights.bumpiness * bumpiness;
+} // evaluate
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * Add a placement to the list unless the shape already ends up there
+ * @param out - placements so far
+ * @param count - number in out, counts the new one
+ * @param seen - bit row set for each rotation and column offset placed
+ * @param placement - placement to add
+ * @return true if it was added
+ */
+static bool addPlacement(Placement out[], int& count, uint32_t seen[][COLLISION_OFFSETS],
+                         const Placement& placement) {
+    uint32_t& rows = seen[placement.rotation][placement.column + COLLISION_PAD_LEFT];
+    uint32_t bit = 1u << placement.row;
+    if((rows & bit) || count >= MAX_PLACEMENTS){
+        return false;
+    }
+
+    rows |= bit;
+    out[count++] = placement;
+    return true;
+}
+
+
+/**
+ * @param mask - shape to test
+ * @param offset - column offset, column + COLLISION_PAD_LEFT
+ * @return true if a block is in a wall at that offset on any row
+ */
+static bool insideWalls(const ShapeMask& mask, int offset) {
+    uint32_t walls = 0;
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        walls |= mask.shifted[shapeRow][offset] & ROW_EMPTY;
+    }
+    return walls != 0;
+}
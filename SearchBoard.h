@@ -0,0 +1,55 @@
+// File: SearchBoard.h
+//   By: John Holik
+// Desc: Bare board used by the AI players. Only the padded row masks
+//       of the collision kernel are kept, so a board is a small plain
+//       copy and placing a shape is a handful of bit operations.
+
+#ifndef TETRIS3_SEARCHBOARD_H
+#define TETRIS3_SEARCHBOARD_H
+#include "tetris.h"
+#include "Tetromino.h"
+#include "Collision.h"
+#include "BoardState.h"
+#include <cstdint>
+
+// most placements one shape can have (4 rotations x every offset
+// dropped straight down, and as many again tucked or spun in)
+const int MAX_PLACEMENTS = 8 * COLLISION_OFFSETS;
+
+struct Placement{
+    int8_t rotation;   // rotations from the starting position
+    int8_t column;     // grid column of the shape's left side
+    int8_t row;        // grid row of the shape's top row after dropping
+
+    // a tuck or spin is dropped to finishRow in finishColumn, then one
+    // more move is made before it falls the rest of the way
+    int8_t finish;        // InputBits of that move (see GameInput.h), 0 for none
+    int8_t finishColumn;  // column before the move
+    int8_t finishRow;     // row the move is made at
+};
+
+struct SearchBoard{
+    uint32_t rows[GAME_ROWS]; // padded row masks, index 0 is the bottom
+
+    void clear();
+    void fromState(const BoardState& state);
+
+    int dropRow(const ShapeMask& mask, int column, int row) const;
+    int place(const ShapeMask& mask, int column, int row);
+    int placements(Tetromino::ShapeType type, Placement out[]) const;
+    bool route(Tetromino::ShapeType type, Placement& placement) const;
+};
+
+// weights of the board features used to score a board
+struct EvalWeights{
+    float height;     // sum of the column heights
+    float lines;      // lines cleared by the placement
+    float holes;      // empty cells with a filled cell above them
+    float bumpiness;  // height differences between neighbor columns
+};
+
+const EvalWeights DEFAULT_WEIGHTS = {-0.510066f, 0.760666f, -0.35663f, -0.184483f};
+
+float evaluate(const SearchBoard& board, int lines, const EvalWeights& weights);
+
+#endif //TETRIS3_SEARCHBOARD_H
@@ -0,0 +1,142 @@
+// File: SnapshotRing.cpp
+//   By: John Holik
+// Desc: Implementation of the board snapshot ring
+
+#include "SnapshotRing.h"
+#include <cstring>
+
+
+/**
+ * Property constructor
+ * @param capacity - ticks kept, older ticks are dropped
+ */
+SnapshotRing::SnapshotRing(int capacity)
+        : _capacity{capacity < 1 ? 1 : capacity},
+          _ticks{new TickSnapshot[_capacity]}, _grids{new GridSnapshot[_capacity]},
+          _empty{true}, _oldestTick{0}, _newestTick{0}, _newestGrid{0} { }
+
+/**
+ * Destructor frees the ring
+ */
+SnapshotRing::~SnapshotRing() {
+    delete[] _ticks;
+    delete[] _grids;
+}
+
+/**
+ * Forget every snapshot
+ */
+void SnapshotRing::clear() {
+    _empty = true;
+    _oldestTick = 0;
+    _newestTick = 0;
+    _newestGrid = 0;
+} // clear
+
+/**
+ * Save the board of a tick. Ticks are recorded in order; recording a
+ * tick at or before the newest drops the snapshots after it, and
+ * skipping ticks starts the history over.
+ * @param tick - tick of the board
+ * @param state - board at that tick
+ */
+void SnapshotRing::record(uint32_t tick, const BoardState& state) {
+    if(_empty || tick > _newestTick + 1 || tick <= _oldestTick){
+        _empty = true;
+        _oldestTick = tick;
+    }
+
+    // a grid is only stored when it differs from the last tick's
+    bool newGrid = _empty;
+    if(!_empty){
+        const TickSnapshot& last = _ticks[(tick - 1) % _capacity];
+        newGrid = std::memcmp(_grids[last.grid % _capacity].cells, state.cells,
+                              sizeof(state.cells)) != 0;
+        _newestGrid = last.grid; // ticks after 'tick - 1' may have been dropped
+    }
+    if(newGrid){
+        _newestGrid += _empty ? 0 : 1;
+        std::memcpy(_grids[_newestGrid % _capacity].cells, state.cells, sizeof(state.cells));
+    }
+
+    TickSnapshot& snapshot = _ticks[tick % _capacity];
+    snapshot.tick = tick;
+    snapshot.grid = _newestGrid;
+    snapshot.shape = state.shape;
+    snapshot.nextShape = state.nextShape;
+    snapshot.rotation = state.rotation;
+    snapshot.column = state.column;
+    snapshot.row = state.row;
+    snapshot.gameOver = state.gameOver;
+    snapshot.pendingGarbage = state.pendingGarbage;
+    snapshot.garbageHole = state.garbageHole;
+    snapshot.newShapeFrame = state.newShapeFrame;
+    snapshot.autoMoveFrame = state.autoMoveFrame;
+    snapshot.linesCleared = state.linesCleared;
+    snapshot.seed = state.seed;
+    snapshot.shapesGenerated = state.shapesGenerated;
+
+    _empty = false;
+    _newestTick = tick;
+    if(_newestTick - _oldestTick >= uint32_t(_capacity)){
+        _oldestTick = _newestTick - _capacity + 1;
+    }
+} // record
+
+/**
+ * Save the board of a tick
+ * @param tick - tick of the board
+ * @param board - board at that tick
+ */
+void SnapshotRing::record(uint32_t tick, TetrisBoard& board) {
+    BoardState state;
+    board.getState(state);
+    record(tick, state);
+} // record
+
+/**
+ * @param tick - tick to look up
+ * @param state - receives the board at that tick
+ * @return false if the tick is not in the history
+ */
+bool SnapshotRing::restore(uint32_t tick, BoardState& state) {
+    if(_empty || tick < _oldestTick || tick > _newestTick){
+        return false;
+    }
+
+    const TickSnapshot& snapshot = _ticks[tick % _capacity];
+    std::memcpy(state.cells, _grids[snapshot.grid % _capacity].cells, sizeof(state.cells));
+    state.shape = snapshot.shape;
+    state.nextShape = snapshot.nextShape;
+    state.rotation = snapshot.rotation;
+    state.column = snapshot.column;
+    state.row = snapshot.row;
+    state.gameOver = snapshot.gameOver;
+    state.pendingGarbage = snapshot.pendingGarbage;
+    state.garbageHole = snapshot.garbageHole;
+    state.newShapeFrame = snapshot.newShapeFrame;
+    state.autoMoveFrame = snapshot.autoMoveFrame;
+    state.linesCleared = snapshot.linesCleared;
+    state.seed = snapshot.seed;
+    state.shapesGenerated = snapshot.shapesGenerated;
+    return true;
+} // restore
+
+/**
+ * Put a board back to an earlier tick and drop the ticks after it,
+ * so the next record() continues from there
+ * @param tick - tick to go back to
+ * @param board - board to restore
+ * @return false if the tick is not in the history
+ */
+bool SnapshotRing::rewind(uint32_t tick, TetrisBoard& board) {
+    BoardState state;
+    if(!restore(tick, state)){
+        return false;
+    }
+    board.setState(state);
+
+    _newestTick = tick;
+    _newestGrid = _ticks[tick % _capacity].grid;
+    return true;
+} // rewind
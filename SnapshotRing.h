@@ -0,0 +1,82 @@
+// File: SnapshotRing.h
+//   By: John Holik
+// Desc: Fixed size history of a board, one snapshot per tick, for undo,
+//       rollback and backtracking. A tick snapshot is the 32 byte piece,
+//       counter and shape sequence part of a BoardState plus the number
+//       of a grid snapshot. The grid only changes when a shape locks, so
+//       a grid is stored only when it differs from the last one and the
+//       ticks in between share it. Nothing is allocated after the ring
+//       is created and rewinding is one BoardState copy.
+
+#ifndef TETRIS3_SNAPSHOTRING_H
+#define TETRIS3_SNAPSHOTRING_H
+#include "tetris.h"
+#include "BoardState.h"
+#include "TetrisBoard.h"
+#include <cstdint>
+
+const int SNAPSHOT_TICKS = FPS * 10; // default history, ten seconds
+
+struct TickSnapshot{
+    uint32_t tick;
+    uint32_t grid;             // number of the grid snapshot in use
+    int8_t shape;              // same meaning as in BoardState
+    int8_t nextShape;
+    int8_t rotation;
+    int8_t column;
+    int8_t row;
+    int8_t gameOver;
+    int8_t pendingGarbage;
+    int8_t garbageHole;
+    int16_t newShapeFrame;
+    int16_t autoMoveFrame;
+    int32_t linesCleared;
+    uint32_t seed;
+    uint32_t shapesGenerated;
+};
+
+struct GridSnapshot{
+    uint64_t cells[GAME_ROWS]; // BoardState::cells
+};
+
+
+class SnapshotRing {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    explicit SnapshotRing(int capacity = SNAPSHOT_TICKS);
+
+    ~SnapshotRing(); // destructor
+
+    SnapshotRing(const SnapshotRing& other) = delete;
+    SnapshotRing& operator=(const SnapshotRing& rhs) = delete;
+
+    // Accessors
+    // --------------------------------------------------------
+    bool isEmpty() {return _empty;}
+    uint32_t getOldestTick() {return _oldestTick;}
+    uint32_t getNewestTick() {return _newestTick;}
+
+    // Methods
+    // --------------------------------------------------------
+    void clear();
+
+    void record(uint32_t tick, const BoardState& state);
+    void record(uint32_t tick, TetrisBoard& board);
+
+    bool restore(uint32_t tick, BoardState& state);
+    bool rewind(uint32_t tick, TetrisBoard& board);
+
+private:
+    int _capacity;
+    TickSnapshot* _ticks;  // slot tick % capacity
+    GridSnapshot* _grids;  // slot grid % capacity
+
+    bool _empty;
+    uint32_t _oldestTick;
+    uint32_t _newestTick;
+    uint32_t _newestGrid;
+};
+
+
+#endif //TETRIS3_SNAPSHOTRING_H
@@ -3,27 +3,37 @@
 // Desc:
 
 #include <iostream>
+#include <algorithm>
+#include <random>
 #include "TetrisBoard.h"
-#include "ShapeI.h"
-#include "ShapeJ.h"
-#include "ShapeL.h"
-#include "ShapeO.h"
-#include "ShapeS.h"
-#include "ShapeT.h"
-#include "ShapeZ.h"
+#include "KickTable.h"
+#include "Trace.h"
+#include "Metrics.h"
 #include "tetris.h"
 
-// local functions
-bool isKeyPressed(KeyPressedState input[], sf::Keyboard::Key);
 
 /**
- * Default constructor sets up the board
+ * Default constructor sets up the board with a random piece sequence
  */
-TetrisBoard::TetrisBoard() {
+TetrisBoard::TetrisBoard() : TetrisBoard(std::random_device{}()) { }
+
+/**
+ * Property constructor sets up the board
+ * @param seed - seed for the random shape generator, boards with the
+ *               same seed get the same sequence of shapes
+ */
+TetrisBoard::TetrisBoard(unsigned int seed) {
 
     //initialize frame counters
     _counters = {FRAMES_NEW_SHAPE, 0,
                   FRAMES_AUTO_MOVE, 0};
+    _startLevel = 0;
+
+    _gameOver = false;
+    _linesCleared = 0;
+    _lastCleared = 0;
+    _pendingGarbage = 0;
+    _garbageHole = 0;
 
     // set up the game board grid
     // --------------------------------------------------
@@ -44,36 +54,35 @@ TetrisBoard::TetrisBoard() {
         for(int col = 0; col < GAME_COLUMNS; ++col){
             block.setPosition(position); // set screen position of block
 
-            _cells[row][col] = {false, block}; // copy shape to grid
+            _cells[row][col] = {false, CELL_EMPTY, block}; // copy shape to grid
 
             position.x += size.x; // move block right 1 cell
         } // columns left to right
 
+        _rowMasks[row] = ROW_EMPTY; // nothing filled yet
+
         position.x = GRID_LEFT; // rest block left to left side of grid
         position.y += size.y;  // move block down to next row of grid
     } // rows from top down to bottom
-    _randGenerator = std::mt19937 (_randDevice()); // see the generator engine
-    _randDistribution = std::uniform_int_distribution<>(Tetromino::ShapeType::SHAPE_NONE + 1,
-                                                        Tetromino::ShapeType::SHAPE_COUNT -1);
+    _seed = seed;
+    _shapesGenerated = 0;
 
-    _currentShape = nullptr;
-    _nextShape = nullptr;
+    _currentShape = Tetromino::SHAPE_NONE;
+    _currentRotation = 0;
     _currentCell = sf::Vector2i{0,0};
 
-    // get the next shape
+    _shapeBlock.setSize(size);
+
+    // fill the preview from the start of the sequence
+    _preview.reset(_seed, 0, PREVIEW_DEFAULT);
     nextShape();
 
-} // default
+} // property
 
 /**
  * Destructor cleans up gameboard objects
  */
 TetrisBoard::~TetrisBoard() {
-    delete _currentShape;
-    _currentShape = nullptr;
-
-    delete _nextShape;
-    _nextShape = nullptr;
 }
 /**
  * Update shape objects on the Tetris board
@@ -82,25 +91,30 @@ TetrisBoard::~TetrisBoard() {
  * @return true if game should end
  */
 bool TetrisBoard::Update(KeyPressedState *input) {
-    bool endGame = false;
+    TRACE_SCOPE("TetrisBoard::Update");
+    gameMetrics().updatesRun.add();
+    bool endGame = _gameOver;
+    _lastCleared = 0;
+
+    if(endGame){
+        return endGame; // nothing moves once the game is over
+    }
 
     // Check if spacebar was pressed to rotate the shape
-    if(_currentShape) {
+    if(_currentShape != Tetromino::SHAPE_NONE) {
         if (isKeyPressed(input, sf::Keyboard::Key::Space)) {
             if (canRotateShape()) {
-                _currentShape->rotate();
+                _currentRotation = (_currentRotation + 1) % 4;
             }
         }
 
         if (isKeyPressed(input, sf::Keyboard::Key::A)) {
             if(canMove(Tetromino::Movement::MoveLeft)){
-                _currentShape->move(Tetromino::Movement::MoveLeft);
                 _currentCell.x -= 1;
             }
         }
         else if (isKeyPressed(input, sf::Keyboard::Key::D)) {
             if(canMove(Tetromino::Movement::MoveRight)){
-                _currentShape->move(Tetromino::Movement::MoveRight);
                 _currentCell.x += 1;
             }
         }
@@ -111,12 +125,20 @@ bool TetrisBoard::Update(KeyPressedState *input) {
             moveDown = true;
         } // user move down
 
-        //if user requests or if it's time to auto move shape
-        if(moveDown || _counters.autoMove >= _counters.autoMoveRate){
+        if(_startLevel > 0){
+            // add up the gravity, whole rows fall now and the fraction
+            // carries on to the next tick
+            _counters.autoMove += gravityForLevel(getLevel());
+            int rows = _counters.autoMove / GRAVITY_ONE;
+            _counters.autoMove %= GRAVITY_ONE;
+
+            dropShape(moveDown ? rows + 1 : rows);
+        } // gravity level
+        else if(moveDown || _counters.autoMove >= _counters.autoMoveRate){
+            //user requests or it's time to auto move shape
             // see if we can move it down first
             if(canMove(Tetromino::Movement::MoveDown)){
                 // if yes move down
-                _currentShape->move(Tetromino::Movement::MoveDown);
                 _currentCell.y -= 1;
             }
             // reset auto move counter
@@ -129,12 +151,22 @@ bool TetrisBoard::Update(KeyPressedState *input) {
 
         if(!canMove(Tetromino::Movement::MoveDown)){
             lockShape();
-            delete _currentShape;
-            _currentShape = nullptr;
+            _currentShape = Tetromino::SHAPE_NONE;
+            _currentRotation = 0;
+
+            _lastCleared = clearLines();
+            gameMetrics().linesCleared.add(uint64_t(_lastCleared));
+            _linesCleared += _lastCleared;
+
+            // garbage from opponents arrives once the shape is locked
+            if(_pendingGarbage > 0 && !insertGarbage()){
+                endGame = true;
+            }
         }
 
-        if (isKeyPressed(input, sf::Keyboard::Key::LShift)) {
-            std::cout << _currentShape->toString() << std::endl;
+        if (_currentShape != Tetromino::SHAPE_NONE && isKeyPressed(input, sf::Keyboard::Key::LShift)) {
+            std::cout << pieceSet().getPiece(_currentShape).name << " rotation " << _currentRotation
+                      << " at (" << _currentCell.x << "," << _currentCell.y << ")" << std::endl;
         }
     }
     else{// no current shape
@@ -143,19 +175,110 @@ bool TetrisBoard::Update(KeyPressedState *input) {
             _counters.newShape++; // increase frame counter
         } else {// show next shape
             _counters.newShape = 0; // reset counter
-            _currentShape = _nextShape; // copy next to current
-            nextShape(); // get the next shape
+            _currentShape = _preview.pop(); // next becomes current
+            _currentRotation = 0;
+            nextShape();
+
+            // no room for the new shape
+            if(hasCollision(_currentShape, _currentRotation, _currentCell)){
+                endGame = true;
+            }
         }
     } // current shape
+
+    _gameOver = endGame;
     return endGame;
 } // boardUpdate
 
 
+/**
+ * Queue garbage rows sent by an opponent. They are pushed in from the
+ * bottom of the board when the current shape locks.
+ * @param rows - number of garbage rows
+ * @param holeColumn - the one open column in each garbage row
+ */
+void TetrisBoard::addGarbage(int rows, int holeColumn) {
+    _pendingGarbage += rows;
+    _garbageHole = holeColumn;
+} // addGarbage
+
+
+/**
+ * Copy the grid and shapes into a compact board state
+ * @param state - receives the board
+ */
+void TetrisBoard::getState(BoardState& state) {
+    for(int row = 0; row < GAME_ROWS; ++row){
+        uint64_t cells = 0;
+        for(int col = 0; col < GAME_COLUMNS; ++col){
+            cells |= uint64_t(_cells[row][col].color) << (col * CELL_BITS);
+        }
+        state.cells[row] = cells;
+    } // each row
+
+    state.shape = _currentShape;
+    state.nextShape = _preview.peek(0);
+    state.rotation = _currentRotation;
+    state.column = _currentCell.x;
+    state.row = _currentCell.y;
+
+    state.gameOver = _gameOver;
+    state.pendingGarbage = _pendingGarbage;
+    state.garbageHole = _garbageHole;
+    state.newShapeFrame = _counters.newShape;
+    state.autoMoveFrame = _counters.autoMove;
+    state.linesCleared = _linesCleared;
+    state.seed = _seed;
+    state.shapesGenerated = _shapesGenerated;
+} // getState
+
+
+/**
+ * Replace the whole board with a board state, used to rebuild a board
+ * from a stream or a saved game
+ * @param state - board to copy
+ */
+void TetrisBoard::setState(const BoardState& state) {
+    for(int row = 0; row < GAME_ROWS; ++row){
+        _rowMasks[row] = ROW_EMPTY;
+
+        for(int col = 0; col < GAME_COLUMNS; ++col){
+            int color = cellAt(state, row, col);
+
+            _cells[row][col].filled = color != CELL_EMPTY;
+            _cells[row][col].color = color;
+            _cells[row][col].block.setFillColor(cellColor(color));
+            if(color != CELL_EMPTY){
+                _rowMasks[row] |= 1u << (col + COLLISION_PAD_LEFT);
+            }
+        } // each column
+    } // each row
+
+    _currentShape = state.shape;
+    _currentRotation = state.shape != Tetromino::SHAPE_NONE ? state.rotation : 0;
+    _currentCell = sf::Vector2i(state.column, state.row);
+
+    _gameOver = state.gameOver;
+    _pendingGarbage = state.pendingGarbage;
+    _garbageHole = state.garbageHole;
+    _counters.newShape = state.newShapeFrame;
+    _counters.autoMove = state.autoMoveFrame;
+    _linesCleared = state.linesCleared;
+    _lastCleared = 0;
+
+    // same point in the same shape sequence
+    _seed = state.seed;
+    _shapesGenerated = state.shapesGenerated;
+    _preview.reset(_seed, _shapesGenerated - 1, _preview.getLength());
+} // setState
+
+
 /**
  * draw game objects on the window
  * @param window - main game window
  */
 void TetrisBoard::render(sf::RenderWindow &window) {
+    TRACE_SCOPE("TetrisBoard::render");
     // draw the grid
     for(int row = 0; row < GAME_ROWS; ++row){
         for(int col = 0; col < GAME_COLUMNS; ++col){
@@ -164,57 +287,79 @@ void TetrisBoard::render(sf::RenderWindow &window) {
     } // each row
 
     // draw current shape if we have one
-    if(_currentShape) {
-        _currentShape->draw(window);
+    if(_currentShape != Tetromino::SHAPE_NONE) {
+        const ShapeMask& mask = shapeMask(Tetromino::ShapeType(_currentShape), _currentRotation);
+        sf::Vector2f position = cellPosition(_currentCell);
+
+        _shapeBlock.setFillColor(cellColor(pieceSet().getPiece(_currentShape).color));
+        for(int row = 0; row < mask.rows; ++row){
+            for(int column = 0; column < mask.columns; ++column){
+                if((mask.bits[row] >> column) & 1u){
+                    _shapeBlock.setPosition(position.x + column * BLOCK_SIZE,
+                                            position.y + row * BLOCK_SIZE);
+                    window.draw(_shapeBlock);
+                }
+            } // each column
+        } // each row
     }
 } // render
 
 
+/**
+ * Draw the shapes coming up in a column, the next shape at the top
+ * @param window - main game window
+ * @param position - screen position of the panel's top left
+ */
+void TetrisBoard::renderPreview(sf::RenderWindow& window, sf::Vector2f position) {
+    TRACE_SCOPE("TetrisBoard::renderPreview");
+    const float size = BLOCK_SIZE / 2.f;
+    _shapeBlock.setSize(sf::Vector2f(size, size));
+
+    for(int ahead = 0; ahead < _preview.getLength(); ++ahead){
+        int shape = _preview.peek(ahead);
+        const ShapeMask& mask = shapeMask(Tetromino::ShapeType(shape), 0);
+        float top = position.y + ahead * PREVIEW_SLOT_HEIGHT;
+
+        _shapeBlock.setFillColor(cellColor(pieceSet().getPiece(shape).color));
+        for(int row = 0; row < mask.rows; ++row){
+            for(int column = 0; column < mask.columns; ++column){
+                if((mask.bits[row] >> column) & 1u){
+                    _shapeBlock.setPosition(position.x + column * size, top + row * size);
+                    window.draw(_shapeBlock);
+                }
+            } // each column
+        } // each row
+    } // each shape coming up
+
+    _shapeBlock.setSize(sf::Vector2f(BLOCK_SIZE, BLOCK_SIZE));
+} // renderPreview
+
+
 // Private methods
 // ---------------------------------------------
 
 /**
-* Randomly selects the next shape to show
+* Moves on to the next shape, the preview already holds it
 */
 void TetrisBoard::nextShape() {
+    TRACE_SCOPE("TetrisBoard::nextShape");
+    gameMetrics().piecesSpawned.add();
     // reset current shape cell to top center
     _currentCell = sf::Vector2i (START_CELL_COLUMN, START_CELL_ROW);
 
-    // calc starting screen position
-    float x = (_currentCell.x + 1) * BLOCK_SIZE;
-    float y = (GAME_ROWS - _currentCell.y) * BLOCK_SIZE;
-    sf::Vector2f position{x,y};
-
-    // generate random shape type
-    auto nextType = static_cast<Tetromino::ShapeType>(_randDistribution(_randGenerator));
-
+    ++_shapesGenerated;
+}
 
-    // generate a shape for nextShape
-    switch (nextType) {
 
-        case Tetromino::ShapeType::SHAPE_I:
-            _nextShape = new ShapeI(position);
-            break;
-        case Tetromino::ShapeType::SHAPE_J:
-            _nextShape = new ShapeJ(position);
-            break;
-        case Tetromino::ShapeType::SHAPE_L:
-            _nextShape = new ShapeL(position);
-            break;
-        case Tetromino::ShapeType::SHAPE_O:
-            _nextShape = new ShapeO(position);
-            break;
-        case Tetromino::ShapeType::SHAPE_S:
-            _nextShape = new ShapeS(position);
-            break;
-        case Tetromino::ShapeType::SHAPE_T:
-            _nextShape = new ShapeT(position);
-            break;
-        case Tetromino::ShapeType::SHAPE_Z:
-            _nextShape = new ShapeZ(position);
-            break;
-    }
-}
+/**
+ * @param cell - grid column and row of a shape's top left
+ * @return screen position of the shape
+ */
+sf::Vector2f TetrisBoard::cellPosition(sf::Vector2i cell) {
+    float x = (cell.x + 1) * BLOCK_SIZE;
+    float y = (GAME_ROWS - cell.y) * BLOCK_SIZE;
+    return sf::Vector2f{x,y};
+} // cellPosition
 
 
 /**
@@ -242,7 +387,47 @@ bool isKeyPressed(KeyPressedState input[], sf::Keyboard::Key key){
 }// is key pressed
 
 
+/**
+ * @param color - color index of a grid cell (see BoardState.h)
+ * @return fill color for the cell
+ */
+sf::Color cellColor(int color){
+    // shape colors in ShapeType order
+    static const unsigned int SHAPE_COLORS[Tetromino::SHAPE_COUNT] = {
+            Tetromino::LIGHT_BLUE, Tetromino::DARK_BLUE, Tetromino::ORANGE, Tetromino::YELLOW,
+            Tetromino::GREEN, Tetromino::MAGENTA, Tetromino::RED};
+
+    sf::Color fill = BACKGROUND_COLOR;
+    if(color == CELL_GARBAGE){
+        fill = GARBAGE_COLOR;
+    } else if(color != CELL_EMPTY){
+        fill = sf::Color(SHAPE_COLORS[color - 1]);
+    }
+    return fill;
+}// cellColor
+
+
+/**
+ * Shape at position index of a sequence. A hash of the seed and index
+ * rather than a running generator, so any point of the sequence can
+ * be restored from the two numbers alone.
+ * @param seed - picks the sequence
+ * @param index - shapes drawn before this one
+ * @return shape type
+ */
+Tetromino::ShapeType shapeAt(unsigned int seed, unsigned int index){
+    // splitmix64 finalizer
+    uint64_t bits = (uint64_t(seed) << 32 | index) + 0x9E3779B97F4A7C15ull;
+    bits = (bits ^ (bits >> 30)) * 0xBF58476D1CE4E5B9ull;
+    bits = (bits ^ (bits >> 27)) * 0x94D049BB133111EBull;
+    bits ^= bits >> 31;
+
+    return Tetromino::ShapeType(bits % unsigned(pieceSet().getCount()));
+}// shapeAt
+
+
 bool TetrisBoard::canMove(Tetromino::Movement direction) {
+    TRACE_SCOPE("TetrisBoard::canMove");
     bool canMove = true;
 
     // make a copy of the current cell
@@ -257,7 +442,7 @@ bool TetrisBoard::canMove(Tetromino::Movement direction) {
                 tempCell.x -= 1;
             break;
         case Tetromino::MoveRight:
-            if(_currentCell.x + _currentShape->getColumns() > GAME_COLUMNS + 1)
+            if(_currentCell.x + shapeMask(Tetromino::ShapeType(_currentShape), _currentRotation).columns > GAME_COLUMNS + 1)
                 canMove = false;
             else
                 tempCell.x += 1;
@@ -270,122 +455,206 @@ bool TetrisBoard::canMove(Tetromino::Movement direction) {
     }// direction
 
     if(canMove){
-        // declare temp shape so default constructor is called to
-        Tetromino tempShape;
-
-        // make a copy of the current shape to temp shape
-        tempShape = *_currentShape;
-
-        canMove = !hasCollision(tempShape, tempCell);
+        canMove = !hasCollision(_currentShape, _currentRotation, tempCell);
     }
     return canMove;
 } // canMove
 
 
+/**
+ * Move the current shape down as far as it can fall, up to a number of
+ * rows, finding where it lands with dropDistance()
+ * @param rows - most rows to fall
+ */
+void TetrisBoard::dropShape(int rows) {
+    const ShapeMask& mask = shapeMask(Tetromino::ShapeType(_currentShape), _currentRotation);
+    _currentCell.y -= ::dropDistance(_rowMasks, mask, _currentCell.x, _currentCell.y, rows);
+} // dropShape
+
+
 /**
  * Determine if a shape can rotate without colliding with any existing shapes
- * Shape may have to perform a wall-kick to put it back inside the gameboard.
+ * Shape may have to perform a wall-kick to find a place it fits.
  * @return true if it can rotate
  */
 bool TetrisBoard::canRotateShape(){
-    bool canRotate = true;
-
+    TRACE_SCOPE("TetrisBoard::canRotateShape");
     //make a copy of the current cell
     sf::Vector2i tempCell = _currentCell;
 
-    //make sure location and shape are inside gameboard
-    wallKick(tempCell);
-
-    Tetromino tempShape;
-    tempShape = *_currentShape;
-    tempShape.rotate();
-
-    canRotate = !hasCollision(tempShape, tempCell);
+    //move the location to the first kick the rotated shape fits at
+    bool canRotate = wallKick(tempCell);
 
     if(canRotate){
-        int diffX = std::abs(tempCell.x - _currentCell.x);
-        if(diffX > 0){
-            // assume on left wall (x is -) so move right
-            auto dir = Tetromino::Movement::MoveRight;
-            if(_currentCell.x > 0)// if the x was + then on right side
-                dir = Tetromino::Movement::MoveLeft;
-            _currentShape->move(dir,diffX);
-            _currentCell = tempCell;
-        }
+        _currentCell = tempCell;
     }
 
-    
     return canRotate;
 }// canRotate
 
 
 /**
- * Move the location of a shape back inside the gameboard
- * @param location - of the current shape
+ * Move the location of a shape to the first SRS kick where the shape
+ * fits once rotated
+ * @param location - of the current shape, moved by the kick
+ * @return false if the rotated shape fits at none of the kicks
  */
-void TetrisBoard::wallKick(sf::Vector2i location) {
-    if(location.x <0){
-        location.x = 0;
-    }
-    else if (location.x + _currentShape->getColumns() >= GAME_COLUMNS){
-        int diff = location.x + _currentShape->getColumns() - GAME_COLUMNS;
-        location.x -= diff;
+bool TetrisBoard::wallKick(sf::Vector2i& location) {
+    Tetromino::ShapeType type = Tetromino::ShapeType(_currentShape);
+    int rotation = _currentRotation;
+
+    int kick = findKick(_rowMasks, type, rotation, location.x, location.y);
+    if(kick < 0){
+        return false;
     }
+
+    const Kick& offset = rotationKicks(type, rotation).kicks[kick];
+    location.x += offset.column;
+    location.y += offset.row;
+    return true;
 }// wallKick
 
 
 
 /**
  * See if any of the blocks in a shape overlay a block in the grid or are outside of the walls
- * @param shape - reference to the shape to check
+ * @param shape - piece number of the shape to check
+ * @param rotation - rotation of the shape
  * @param location - location of the shape
  * @return true if there is a collision
  */
-bool TetrisBoard::hasCollision(Tetromino& shape, sf::Vector2i location){
-    bool collision = false;
-
-    // used to indicate if current block is in grid or outside walls
-    bool filled{};
-
-    //check if temp shape at new temp cell location has any collisions
-    for(int row = 0; row < shape.getRows() && !collision; ++row){
-
-        for(int column = 0; column < shape.getColumns() && !collision; ++column){
-            // check if grid cell is filled
-            if(location.x + column < 0 ||
-               location.x + column >= GAME_COLUMNS ||
-               location.y - row < 0){
-                filled = true;
-            } else{
-                filled = _cells[location.y - row][location.x + column].filled;
-            }
+bool TetrisBoard::hasCollision(int shape, int rotation, sf::Vector2i location){
+    const ShapeMask& mask = shapeMask(Tetromino::ShapeType(shape), rotation);
 
-            // check for collision between temp shape and grid cell
-            if(filled and shape.hasBlock(row, column)){
-                collision = true;
-            }
-        }// each column
-    }// each row
-    return collision;
+    return ::hasCollision(_rowMasks, mask, location.x, location.y);
 } // hasCollision
 
 
+/**
+ * Test a shape against every column of the board at once
+ * @param mask - shape to test (see shapeMask())
+ * @param row - grid row of the shape's top row
+ * @return bit (column + COLLISION_PAD_LEFT) set for each column the
+ *         shape fits in without a collision
+ */
+unsigned int TetrisBoard::legalColumns(const ShapeMask& mask, int row) {
+    return ::legalColumns(_rowMasks, mask, row);
+} // legalColumns
+
+
 
 /**
 * Lock the current shape into the current position on gameboard
 */
 void TetrisBoard::lockShape() {
-    for(int row = 0; row < _currentShape->getRows(); ++row){
-        for(int column = 0; column < _currentShape->getColumns(); ++column){
-            if(_currentCell.x + column >= 0 ||
-               _currentCell.x + column <= (GAME_COLUMNS - 1) ||
-               _currentCell.y - row >= 0){
-                if(_currentShape->hasBlock(row,column)){
-                    _cells[_currentCell.y - row][_currentCell.x + column].block.setFillColor(_currentShape->getFillColor());
+    TRACE_SCOPE("TetrisBoard::lockShape");
+    gameMetrics().locks.add();
+    const ShapeMask& mask = shapeMask(Tetromino::ShapeType(_currentShape), _currentRotation);
+    int color = pieceSet().getPiece(_currentShape).color;
+
+    for(int row = 0; row < mask.rows; ++row){
+        for(int column = 0; column < mask.columns; ++column){
+            if(_currentCell.x + column >= 0 &&
+               _currentCell.x + column <= (GAME_COLUMNS - 1) &&
+               _currentCell.y - row >= 0 && _currentCell.y - row < GAME_ROWS){
+                if((mask.bits[row] >> column) & 1u){
+                    _cells[_currentCell.y - row][_currentCell.x + column].block.setFillColor(cellColor(color));
                     _cells[_currentCell.y - row][_currentCell.x + column].filled = true;
+                    _cells[_currentCell.y - row][_currentCell.x + column].color = color;
+                    _rowMasks[_currentCell.y - row] |= 1u << (_currentCell.x + column + COLLISION_PAD_LEFT);
                 }
             }
             
         }// each column
     }// each row
-}// lockShape
\ No newline at end of file
+}// lockShape
+
+
+/**
+ * Remove any full rows and drop the rows above them down
+ * @return number of rows removed
+ */
+int TetrisBoard::clearLines() {
+    int cleared = 0;
+
+    for(int row = 0; row < GAME_ROWS; ++row){
+        if((_rowMasks[row] & ROW_BOARD_BITS) == ROW_BOARD_BITS){
+            ++cleared; // skip the full row
+        } else if(cleared > 0){
+            copyRow(row, row - cleared);
+        }
+    } // each row bottom up
+
+    // rows left at the top are now empty
+    for(int row = GAME_ROWS - cleared; row < GAME_ROWS; ++row){
+        clearRow(row);
+    }
+
+    return cleared;
+}// clearLines
+
+
+/**
+ * Shift the grid up by the pending garbage rows and fill the bottom
+ * with garbage leaving one hole per row
+ * @return false if filled cells were pushed off the top of the board
+ */
+bool TetrisBoard::insertGarbage() {
+    int rows = std::min(_pendingGarbage, GAME_ROWS);
+    bool toppedOut = false;
+
+    // anything in the top rows is pushed off the board
+    for(int row = GAME_ROWS - rows; row < GAME_ROWS; ++row){
+        if(_rowMasks[row] & ROW_BOARD_BITS){
+            toppedOut = true;
+        }
+    }
+
+    for(int row = GAME_ROWS - 1; row >= rows; --row){
+        copyRow(row - rows, row);
+    }
+
+    for(int row = 0; row < rows; ++row){
+        clearRow(row);
+        for(int col = 0; col < GAME_COLUMNS; ++col){
+            if(col != _garbageHole){
+                _cells[row][col].filled = true;
+                _cells[row][col].color = CELL_GARBAGE;
+                _cells[row][col].block.setFillColor(GARBAGE_COLOR);
+            }
+        }
+        _rowMasks[row] |= ROW_BOARD_BITS & ~(1u << (_garbageHole + COLLISION_PAD_LEFT));
+    } // each garbage row
+
+    _pendingGarbage = 0;
+    return !toppedOut;
+}// insertGarbage
+
+
+/**
+ * Copy the filled state and color of one grid row to another
+ * @param from - source row
+ * @param to - destination row
+ */
+void TetrisBoard::copyRow(int from, int to) {
+    for(int col = 0; col < GAME_COLUMNS; ++col){
+        _cells[to][col].filled = _cells[from][col].filled;
+        _cells[to][col].color = _cells[from][col].color;
+        _cells[to][col].block.setFillColor(_cells[from][col].block.getFillColor());
+    }
+    _rowMasks[to] = _rowMasks[from];
+}// copyRow
+
+
+/**
+ * Empty a grid row
+ * @param row - row to empty
+ */
+void TetrisBoard::clearRow(int row) {
+    for(int col = 0; col < GAME_COLUMNS; ++col){
+        _cells[row][col].filled = false;
+        _cells[row][col].color = CELL_EMPTY;
+        _cells[row][col].block.setFillColor(BACKGROUND_COLOR);
+    }
+    _rowMasks[row] = ROW_EMPTY;
+}// clearRow
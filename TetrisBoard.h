@@ -6,8 +6,13 @@
 #define TETRIS2_TETRISBOARD_H
 #include "tetris.h"
 #include "Tetromino.h"
+#include "Collision.h"
+#include "BoardState.h"
+#include "Gravity.h"
+#include "PieceSet.h"
+#include "PreviewQueue.h"
 #include <SFML/Graphics.hpp>
-#include <random>
+#include <cstdint>
 
 
 class TetrisBoard {
@@ -15,14 +20,45 @@ public:
     // Constructors
     // --------------------------------------------------------
     TetrisBoard(); // default
+    explicit TetrisBoard(unsigned int seed); // fixed piece sequence
 
     ~TetrisBoard(); // destructor
 
+    // Accessors
+    // --------------------------------------------------------
+    bool isGameOver() {return _gameOver;}
+    int getLinesCleared() {return _linesCleared;}
+    int getLastCleared() {return _lastCleared;}
+
+    // ticks before a new shape appears and between automatic moves down
+    void setTiming(int spawnTicks, int gravityTicks) {
+        _counters.newShapeRate = spawnTicks;
+        _counters.autoMoveRate = gravityTicks;
+    }
+
+    // level 1 and up use the gravity curve (see Gravity.h) instead of
+    // the fixed timing, level 0 goes back to the fixed timing
+    void setLevel(int level) {_startLevel = level;}
+    int getLevel() {return _startLevel > 0 ? levelForLines(_startLevel, _linesCleared) : 0;}
+
+    // shapes shown coming up, 1 to PREVIEW_MAX, the first is the next shape
+    void setPreviewLength(int length) {_preview.reset(_seed, _shapesGenerated - 1, length);}
+    int getPreviewLength() {return _preview.getLength();}
+    int getPreview(int ahead) {return _preview.peek(ahead);}
+
     // Methods
     // --------------------------------------------------------
     bool Update(KeyPressedState input[]);
 
+    void addGarbage(int rows, int holeColumn);
+
+    void getState(BoardState& state);
+    void setState(const BoardState& state);
+
     void render(sf::RenderWindow(&window));
+    void renderPreview(sf::RenderWindow& window, sf::Vector2f position);
+
+    unsigned int legalColumns(const ShapeMask& mask, int row);
 
 
 // Private
@@ -32,43 +68,75 @@ private:
         int newShapeRate;
         int newShape;
         int autoMoveRate;
-        int autoMove;
+        int autoMove;     // frames since the last move down, or the
+                          // fraction of a row fallen with a gravity level
     };
 
     FrameCounters _counters;
+    int _startLevel;     // gravity level at the start, 0 for fixed timing
+
+    bool _gameOver;      // shape could not spawn or stack pushed off the top
+    int _linesCleared;   // total lines cleared this game
+    int _lastCleared;    // lines cleared by the last Update()
+    int _pendingGarbage; // garbage rows inserted when the current shape locks
+    int _garbageHole;    // open column of the pending garbage rows
 
     struct GridCell{
         bool filled;
+        unsigned char color; // color index, see BoardState.h
         sf::RectangleShape block;
     };
 
     // grid of cells by row and column
     GridCell _cells[GAME_ROWS][GAME_COLUMNS];
 
-    // current and next shape
-    Tetromino* _currentShape;
-    Tetromino* _nextShape;
+    // filled cells of each row as padded bit masks (see Collision.h)
+    uint32_t _rowMasks[GAME_ROWS];
+
+    // current shape, by number in the piece set (see PieceSet.h)
+    int _currentShape;    // SHAPE_NONE between shapes
+    int _currentRotation; // rotations from the starting position
+
+    // the shapes after it, the front is the next shape
+    PreviewQueue _preview;
+
+    // block drawn for each cell of the current shape
+    sf::RectangleShape _shapeBlock;
 
     // top/left row/column of grid for current shape
     sf::Vector2i _currentCell;
 
-    // properties for generation random numbers
-    // to select the next Tetromino at random
-    // uses a merseene_twister generator engine
-    // to produce a uniform integer distribution
-    std::random_device _randDevice;
-    std::mt19937 _randGenerator;
-    std::uniform_int_distribution<> _randDistribution;
+    // the random shape sequence, shape n is a hash of the seed and n
+    // so these two numbers are the whole generator state
+    unsigned int _seed;            // picks the sequence
+    unsigned int _shapesGenerated; // shapes drawn since seeding, the
+                                   // next shape is number this - 1
 
-    void nextShape(); // calc next random shape
+    void nextShape(); // move on to the next shape in the sequence
+    static sf::Vector2f cellPosition(sf::Vector2i cell);
 
     bool canMove(Tetromino::Movement direction);
+    void dropShape(int rows);
 
     void lockShape(); // locks the current shape in gameboard
+    int clearLines(); // removes full rows, returns number removed
+    bool insertGarbage(); // pushes pending garbage in from the bottom
+    void copyRow(int from, int to);
+    void clearRow(int row);
     bool canRotateShape();
-    void wallKick(sf::Vector2i location);
-    bool hasCollision(Tetromino& shape, sf::Vector2i location);
+    bool wallKick(sf::Vector2i& location);
+    bool hasCollision(int shape, int rotation, sf::Vector2i location);
 };
 
 
+// fill color of a cell color index (see BoardState.h)
+sf::Color cellColor(int color);
+
+// true once for each press of a key, see TetrisBoard::Update()
+bool isKeyPressed(KeyPressedState input[], sf::Keyboard::Key key);
+
+// shape number index of the shape sequence picked by seed
+Tetromino::ShapeType shapeAt(unsigned int seed, unsigned int index);
+
+
 #endif //TETRIS2_TETRISBOARD_H
@@ -0,0 +1,307 @@
+// File: TetrisBot.cpp
+//   By: John Holik
+// Desc: Implementation of the beam search AI player
+
+#include "TetrisBot.h"
+#include "Arena.h"
+#include "BatchEvaluator.h"
+#include "GameInput.h"
+#include "PieceSet.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+// scratch memory of the thread running a search task
+static thread_local Arena scratch;
+
+struct BeamNode{
+    SearchBoard board;
+    Placement first;  // placement of the current shape leading here
+    float score;      // score of this board
+    float value;      // best score found below this node
+};
+
+// local functions
+static bool betterNode(const BeamNode& lhs, const BeamNode& rhs);
+static void scoreNodes(BeamNode nodes[], const int lines[], int count, const EvalWeights& weights);
+static float bestPlacement(const SearchBoard& board, Tetromino::ShapeType type,
+                           const EvalWeights& weights, TranspositionTable& table);
+
+
+/**
+ * Property constructor
+ * @param pool - threads to search with, may be shared with other bots
+ * @param weights - evaluation weights
+ */
+TetrisBot::TetrisBot(WorkStealingPool& pool, const EvalWeights& weights)
+        : _pool{pool}, _weights{weights}, _plannedShape{0},
+          _target{0, START_CELL_COLUMN, 0, 0, 0, 0}, _depthReached{0}, _maxDepth{3},
+          _rollouts{0}, _horizon{0},
+          _finishMade{true} { }
+
+/**
+ * Decide the keys to press this frame. A search is run the first frame
+ * a new shape is seen, after that the shape is steered to the target.
+ * @param state - board this frame
+ * @return InputBits to press
+ */
+unsigned int TetrisBot::nextInput(const BoardState& state) {
+    if(state.shape == Tetromino::SHAPE_NONE || state.gameOver){
+        return INPUT_NONE;
+    }
+
+    // shapesGenerated changes each time a shape is spawned
+    if(state.shapesGenerated != _plannedShape){
+        SearchBoard board{};
+        board.fromState(state);
+
+        // the shape after next, if the board shows that far ahead
+        _preview.reset(state.seed, state.shapesGenerated - 1, _preview.getLength());
+        int third = _preview.getLength() > 1 ? _preview.peek(1) : Tetromino::SHAPE_NONE;
+
+        if(_rollouts > 0){
+            // the same games for every placement, different ones per shape
+            RolloutEvaluator evaluator{_pool, _weights};
+            _target = evaluator.choosePlacement(board, Tetromino::ShapeType(state.shape),
+                                                Tetromino::ShapeType(state.nextShape), _rollouts, _horizon,
+                                                ROLLOUT_GREEDY, state.seed ^ state.shapesGenerated * 2654435761u);
+        } else {
+            _target = search(board, Tetromino::ShapeType(state.shape),
+                             Tetromino::ShapeType(state.nextShape), Tetromino::ShapeType(third));
+        }
+
+        // a result from the table is just the position, find the tuck or
+        // spin that reaches it, if any
+        board.route(Tetromino::ShapeType(state.shape), _target);
+        _finishMade = _target.finish == INPUT_NONE;
+        _plannedShape = state.shapesGenerated;
+    }
+
+    // a tuck or spin is lined up above its row first, dropped to it and
+    // then makes its move
+    int rotation = _target.rotation;
+    int column = _target.column;
+    if(!_finishMade){
+        rotation = _target.finish == INPUT_ROTATE ? (_target.rotation + 3) % 4 : _target.rotation;
+        column = _target.finishColumn;
+
+        if(state.rotation == rotation && state.column == column && state.row <= _target.finishRow){
+            _finishMade = true; // below the row already it just drops
+            if(state.row == _target.finishRow){
+                return unsigned(_target.finish);
+            }
+        }
+    }
+
+    unsigned int input = INPUT_NONE;
+    if(state.rotation != rotation){
+        input |= INPUT_ROTATE;
+    }
+    if(state.column < column){
+        input |= INPUT_RIGHT;
+    } else if(state.column > column){
+        input |= INPUT_LEFT;
+    }
+    if(input == INPUT_NONE){
+        input = INPUT_DOWN; // lined up, drop it
+    }
+    return input;
+} // nextInput
+
+/**
+ * Beam search for the best placement of the current shape
+ * @param board - board without the current shape
+ * @param shape - current shape
+ * @param next - next shape
+ * @param third - shape after next, SHAPE_NONE if it isn't known yet
+ * @return placement to steer the current shape to
+ */
+Placement TetrisBot::search(const SearchBoard& board, Tetromino::ShapeType shape,
+                            Tetromino::ShapeType next, Tetromino::ShapeType third) {
+    TRACE_SCOPE("TetrisBot::search");
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(BOT_BUDGET_MS);
+
+    // the same board, shape and next shape searched as deep before
+    _table.newSearch();
+    uint64_t key = TranspositionTable::key(board, shape, next, third);
+    TableHit hit;
+    if(_table.probe(key, _maxDepth, hit)){
+        _depthReached = hit.depth;
+        return hit.placement;
+    }
+
+    // level 1: every placement of the current shape
+    Placement placements[MAX_PLACEMENTS];
+    int count = board.placements(shape, placements);
+    if(count == 0){
+        return Placement{0, START_CELL_COLUMN, 0, 0, 0, 0};
+    }
+
+    BeamNode nodes[MAX_PLACEMENTS];
+    int lines[MAX_PLACEMENTS];
+    for(int index = 0; index < count; ++index){
+        BeamNode& node = nodes[index];
+        node.board = board;
+        node.first = placements[index];
+
+        const ShapeMask& mask = shapeMask(shape, node.first.rotation);
+        lines[index] = node.board.place(mask, node.first.column, node.first.row);
+    }
+    scoreNodes(nodes, lines, count, _weights);
+
+    // keep the best distinct boards as the beam
+    std::sort(nodes, nodes + count, betterNode);
+    int beam = 0;
+    for(int index = 0; index < count && beam < BOT_BEAM_WIDTH; ++index){
+        bool duplicate = false;
+        for(int kept = 0; kept < beam && !duplicate; ++kept){
+            duplicate = std::memcmp(nodes[kept].board.rows, nodes[index].board.rows,
+                                    sizeof(nodes[index].board.rows)) == 0;
+        }
+        if(!duplicate){
+            nodes[beam++] = nodes[index];
+        }
+    }
+
+    if(_maxDepth < 2){
+        _depthReached = 1;
+        _table.store(key, nodes[0].first, nodes[0].value, _depthReached);
+        return nodes[0].first;
+    }
+
+    // levels 2 and 3, one task per beam node
+    std::atomic<int> deepest{3};
+    auto expand = [&](int task) {
+        TRACE_SCOPE("TetrisBot::expand");
+        BeamNode& node = nodes[task];
+        scratch.reset();
+
+        Placement* children = scratch.allocate<Placement>(MAX_PLACEMENTS);
+        BeamNode* childNodes = scratch.allocate<BeamNode>(MAX_PLACEMENTS);
+        int* childLines = scratch.allocate<int>(MAX_PLACEMENTS);
+        int childCount = node.board.placements(next, children);
+        if(childCount == 0){
+            node.value = -1e9f; // the next shape can't spawn, avoid this
+            return;
+        }
+
+        for(int child = 0; child < childCount; ++child){
+            BeamNode& childNode = childNodes[child];
+            childNode.board = node.board;
+            const ShapeMask& mask = shapeMask(next, children[child].rotation);
+            childLines[child] = childNode.board.place(mask, children[child].column, children[child].row);
+        }
+        scoreNodes(childNodes, childLines, childCount, _weights);
+        std::sort(childNodes, childNodes + childCount, betterNode);
+        node.value = childNodes[0].value;
+
+        // level 3: the shape after next if it is known, otherwise the
+        // average over every shape that could come next
+        if(_maxDepth < 3 || std::chrono::steady_clock::now() >= deadline){
+            deepest = 2;
+            return;
+        }
+        int first = third != Tetromino::SHAPE_NONE ? third : 0;
+        int last = third != Tetromino::SHAPE_NONE ? third + 1 : pieceSet().getCount();
+        int deep = std::min(childCount, BOT_DEEP_WIDTH);
+        float best = -1e9f;
+        for(int child = 0; child < deep; ++child){
+            float total = 0.f;
+            for(int type = first; type < last; ++type){
+                total += bestPlacement(childNodes[child].board, Tetromino::ShapeType(type),
+                                       _weights, _table);
+            }
+            best = std::max(best, total / float(last - first));
+        }
+        node.value = best;
+    };
+    _pool.run(beam, expand);
+    _depthReached = deepest;
+
+    BeamNode* best = std::max_element(nodes, nodes + beam,
+                                      [](const BeamNode& lhs, const BeamNode& rhs) {return lhs.value < rhs.value;});
+    _table.store(key, best->first, best->value, _depthReached);
+    return best->first;
+} // search
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * @return true if lhs has the higher score, for sorting best first
+ */
+static bool betterNode(const BeamNode& lhs, const BeamNode& rhs) {
+    return lhs.score > rhs.score;
+}
+
+/**
+ * Score nodes a batch at a time, sets each node's score and value
+ * @param nodes - nodes to score
+ * @param lines - lines cleared reaching each node
+ * @param count - number of nodes
+ * @param weights - evaluation weights
+ */
+static void scoreNodes(BeamNode nodes[], const int lines[], int count, const EvalWeights& weights) {
+    BoardBatch batch;
+    batch.clear();
+    float scores[EVAL_BATCH];
+
+    for(int first = 0; first < count; first += EVAL_BATCH){
+        batch.count = 0;
+        for(int index = first; index < count && index < first + EVAL_BATCH; ++index){
+            batch.load(index - first, nodes[index].board, lines[index]);
+        }
+        evaluateBatch(batch, weights, scores);
+
+        for(int index = first; index < batch.count + first; ++index){
+            nodes[index].score = scores[index - first];
+            nodes[index].value = nodes[index].score;
+        }
+    }
+}
+
+/**
+ * @param board - board to place on
+ * @param type - shape to place
+ * @param weights - evaluation weights
+ * @param table - cache of results, shared with the other search threads
+ * @return score of the best placement, very low if the shape can't spawn
+ */
+static float bestPlacement(const SearchBoard& board, Tetromino::ShapeType type,
+                           const EvalWeights& weights, TranspositionTable& table) {
+    uint64_t key = TranspositionTable::key(board, type, Tetromino::SHAPE_NONE);
+    TableHit hit;
+    if(table.probe(key, 1, hit)){
+        return hit.score;
+    }
+
+    Placement placements[MAX_PLACEMENTS];
+    int count = board.placements(type, placements);
+
+    SearchBoard after[MAX_PLACEMENTS];
+    int lines[MAX_PLACEMENTS];
+    float scores[MAX_PLACEMENTS];
+    for(int index = 0; index < count; ++index){
+        after[index] = board;
+        lines[index] = after[index].place(shapeMask(type, placements[index].rotation),
+                                          placements[index].column, placements[index].row);
+    }
+    evaluateBoards(after, lines, count, weights, scores);
+
+    float best = -1e9f;
+    int bestIndex = -1;
+    for(int index = 0; index < count; ++index){
+        if(scores[index] > best){
+            best = scores[index];
+            bestIndex = index;
+        }
+    }
+
+    if(bestIndex >= 0){
+        table.store(key, placements[bestIndex], best, 1);
+    }
+    return best;
+}
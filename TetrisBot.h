@@ -0,0 +1,80 @@
+// File: TetrisBot.h
+//   By: John Holik
+// Desc: AI player. When a new shape appears it runs a beam search over
+//       the placements of the current shape, the next shape and, time
+//       permitting, the shape after that if the preview shows it or
+//       else every possible shape after that. The beam nodes are
+//       expanded in parallel on a WorkStealingPool using per-thread
+//       scratch arenas, and the search stops expanding once the frame
+//       budget is used up. Results are cached in a transposition table
+//       shared by the search threads, so boards seen again skip the
+//       search. It can instead pick each placement by Monte Carlo
+//       rollouts (see RolloutEvaluator.h). Between searches the bot just
+//       steers the shape to the chosen placement one key press at a time.
+
+#ifndef TETRIS3_TETRISBOT_H
+#define TETRIS3_TETRISBOT_H
+#include "tetris.h"
+#include "BoardState.h"
+#include "SearchBoard.h"
+#include "WorkStealingPool.h"
+#include "TranspositionTable.h"
+#include "PreviewQueue.h"
+#include "RolloutEvaluator.h"
+#include <cstdint>
+
+const int BOT_BEAM_WIDTH = 12;       // boards kept after the current shape
+const int BOT_DEEP_WIDTH = 4;        // boards per node searched a third shape deep
+const int BOT_BUDGET_MS = FRAME_RATE_MS;
+
+
+class TetrisBot {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    explicit TetrisBot(WorkStealingPool& pool, const EvalWeights& weights = DEFAULT_WEIGHTS);
+
+    // Accessors
+    // --------------------------------------------------------
+    const EvalWeights& getWeights() {return _weights;}
+    void setWeights(const EvalWeights& weights) {_weights = weights; _table.clear();}
+
+    int getDepthReached() {return _depthReached;}
+
+    // below 3 the search ignores the time budget, so it always picks
+    // the same placement for the same board
+    int getMaxDepth() {return _maxDepth;}
+    void setMaxDepth(int depth) {_maxDepth = depth;}
+
+    // shapes the board shows coming up, see TetrisBoard::setPreviewLength()
+    void setPreviewLength(int length) {_preview.reset(0, 0, length);}
+
+    // more than 0 rollouts picks each placement by Monte Carlo rollouts
+    // of horizon shapes (see RolloutEvaluator.h) instead of the search
+    void setRollouts(int rollouts, int horizon) {_rollouts = rollouts; _horizon = horizon;}
+
+    // Methods
+    // --------------------------------------------------------
+    unsigned int nextInput(const BoardState& state);
+
+    Placement search(const SearchBoard& board, Tetromino::ShapeType shape,
+                     Tetromino::ShapeType next,
+                     Tetromino::ShapeType third = Tetromino::SHAPE_NONE);
+
+private:
+    WorkStealingPool& _pool;
+    EvalWeights _weights;
+
+    uint32_t _plannedShape;  // shapesGenerated of the shape being steered
+    Placement _target;
+    int _depthReached;       // deepest level the last search finished
+    int _maxDepth;           // deepest level to search, 1 to 3
+    PreviewQueue _preview;   // the board's preview, rebuilt from each new shape's state
+    int _rollouts;           // games played from each placement, 0 to search instead
+    int _horizon;            // shapes placed in each of those games
+    bool _finishMade;        // the target's tuck or spin move is done or not needed
+    TranspositionTable _table;
+};
+
+
+#endif //TETRIS3_TETRISBOT_H
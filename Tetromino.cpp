@@ -12,18 +12,21 @@
 // Default
 Tetromino::Tetromino() {
     _shapeType = SHAPE_NONE;
+    _rotation = 0;
     // all other properties are class objects win their own
     // default constructors
 }
 Tetromino::Tetromino(int rows, int columns)
         : Matrix{rows, columns}{
     _shapeType = SHAPE_NONE;
+    _rotation = 0;
 }
 
 // Property Constructor #1
 Tetromino::Tetromino(int rows, int columns, int *blocks)
     : Matrix{rows, columns, blocks}{
     _shapeType = SHAPE_NONE;
+    _rotation = 0;
     // all other properties are class objects win their own
     // default constructors
 }
@@ -67,6 +70,7 @@ void Tetromino::draw(sf::RenderWindow &window) {
 
 void Tetromino::rotate() {
     anticlockwise();
+    _rotation = (_rotation + 1) % 4;
 }// End Rotate
 
 /**
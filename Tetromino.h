@@ -27,8 +27,9 @@ public:
     static const unsigned int RED = 0XFF0000FF;
     static const unsigned int MAGENTA = 0XFF00FFFF;
 
-    // known Tetromino shape types
-    enum ShapeType{
+    // known Tetromino shape types, a loaded piece set (see PieceSet.h)
+    // numbers its pieces from 0 the same way and can have more of them
+    enum ShapeType : int{
         SHAPE_NONE = -1,
         SHAPE_I,
         SHAPE_J,
@@ -58,6 +59,8 @@ public:
     // Accessors
     // --------------------------------------------------------
     ShapeType getShapeType() {return _shapeType;}
+
+    int getRotation() {return _rotation;}
     
     sf::Vector2f getSize(){return _size;}
     void setSize(sf::Vector2f size) {_size = size;}
@@ -80,6 +83,7 @@ public:
 
 protected:
     ShapeType _shapeType;
+    int _rotation;           // rotations from the starting position (0-3)
 
     sf::Vector2f _size;      // (width, height)
     sf::Vector2f _position;  // (left, top)
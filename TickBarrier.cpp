@@ -0,0 +1,30 @@
+// File: TickBarrier.cpp
+//   By: John Holik
+// Desc: Implementation of the tick barrier
+
+#include "TickBarrier.h"
+
+/**
+ * Property constructor
+ * @param count - number of threads that must call wait() to open the barrier
+ */
+TickBarrier::TickBarrier(int count)
+        : _count{count}, _waiting{0}, _generation{0} { }
+
+/**
+ * Block until every thread taking part has called wait(). The barrier
+ * resets itself so it can be used again on the next tick.
+ */
+void TickBarrier::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    unsigned long generation = _generation;
+
+    if(++_waiting == _count){
+        // last one in opens the barrier for everyone
+        _waiting = 0;
+        ++_generation;
+        _released.notify_all();
+    } else {
+        _released.wait(lock, [this, generation] {return _generation != generation;});
+    }
+} // wait
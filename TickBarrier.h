@@ -0,0 +1,32 @@
+// File: TickBarrier.h
+//   By: John Holik
+// Desc: Reusable barrier that holds a fixed number of threads until
+//       all of them reach the same point of a simulation tick
+
+#ifndef TETRIS3_TICKBARRIER_H
+#define TETRIS3_TICKBARRIER_H
+#include <mutex>
+#include <condition_variable>
+
+
+class TickBarrier {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    explicit TickBarrier(int count);
+
+    // Methods
+    // --------------------------------------------------------
+    void wait();
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _released;
+
+    int _count;                 // threads taking part
+    int _waiting;               // threads waiting this generation
+    unsigned long _generation;  // bumped each time the barrier opens
+};
+
+
+#endif //TETRIS3_TICKBARRIER_H
@@ -0,0 +1,159 @@
+// File: Trace.cpp
+//   By: John Holik
+// Desc: Implementation of the per-thread trace buffers and the
+//       Chrome trace-event JSON writer
+
+#include "Trace.h"
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> traceEnabled{false};
+
+struct TraceEvent{
+    const char* name;
+    int64_t start;   // microseconds since startTrace()
+    int64_t end;
+};
+
+// events of one thread. Only that thread writes, and it publishes each
+// event by bumping count, so the writer can read the buffer at any time.
+struct TraceBuffer{
+    int thread;                  // tid in the trace file
+    std::atomic<int> count;
+    int dropped;
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+};
+
+// every buffer made, they live until the program ends so a thread that
+// has exited still shows up in the trace
+struct TraceRegistry{
+    std::mutex mutex;
+    std::vector<TraceBuffer*> buffers;
+    std::string path;
+    std::chrono::steady_clock::time_point start;
+
+    ~TraceRegistry(){
+        for(TraceBuffer* buffer : buffers){
+            delete buffer;
+        }
+    }
+};
+
+// local functions
+static TraceRegistry& registry();
+static TraceBuffer* threadBuffer();
+
+
+/**
+ * Start recording events
+ * @param path - JSON file stopTrace() writes
+ */
+void startTrace(const std::string& path) {
+    TraceRegistry& traces = registry();
+    {
+        std::lock_guard<std::mutex> lock{traces.mutex};
+        traces.path = path;
+        traces.start = std::chrono::steady_clock::now();
+    }
+    traceEnabled.store(true);
+} // startTrace
+
+/**
+ * Stop recording and write every event, the threads that made them
+ * should have finished
+ * @return false if the file could not be written
+ */
+bool stopTrace() {
+    if(!traceEnabled.exchange(false)){
+        return true;
+    }
+
+    TraceRegistry& traces = registry();
+    std::lock_guard<std::mutex> lock{traces.mutex};
+
+    std::ofstream out{traces.path};
+    if(!out){
+        return false;
+    }
+
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for(TraceBuffer* buffer : traces.buffers){
+        int count = buffer->count.load(std::memory_order_acquire);
+        for(int index = 0; index < count; ++index){
+            const TraceEvent& event = buffer->events[index];
+            out << (first ? "" : ",\n") << "{\"name\":\"" << event.name
+                << "\",\"ph\":\"X\",\"ts\":" << event.start << ",\"dur\":" << event.end - event.start
+                << ",\"pid\":1,\"tid\":" << buffer->thread << '}';
+            first = false;
+        }
+        if(buffer->dropped > 0){
+            out << (first ? "" : ",\n") << "{\"name\":\"dropped " << buffer->dropped
+                << " events\",\"ph\":\"i\",\"ts\":0,\"s\":\"t\",\"pid\":1,\"tid\":" << buffer->thread << '}';
+            first = false;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return bool(out);
+} // stopTrace
+
+/**
+ * @return microseconds since startTrace()
+ */
+int64_t traceClock() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - registry().start).count();
+}
+
+/**
+ * Add a finished event to the calling thread's buffer
+ * @param name - event name
+ * @param start - from traceClock()
+ * @param end - from traceClock()
+ */
+void addTraceEvent(const char* name, int64_t start, int64_t end) {
+    TraceBuffer* buffer = threadBuffer();
+
+    int count = buffer->count.load(std::memory_order_relaxed);
+    if(count == TRACE_BUFFER_EVENTS){
+        ++buffer->dropped;
+        return;
+    }
+    buffer->events[count] = {name, start, end};
+    buffer->count.store(count + 1, std::memory_order_release);
+} // addTraceEvent
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * @return the buffer list, made on first use
+ */
+static TraceRegistry& registry() {
+    static TraceRegistry traces;
+    return traces;
+}
+
+/**
+ * @return the calling thread's buffer, added to the registry the first
+ *         time the thread traces something
+ */
+static TraceBuffer* threadBuffer() {
+    static thread_local TraceBuffer* buffer = nullptr;
+
+    if(!buffer){
+        TraceRegistry& traces = registry();
+        std::lock_guard<std::mutex> lock{traces.mutex};
+
+        buffer = new TraceBuffer;
+        buffer->thread = int(traces.buffers.size()) + 1;
+        buffer->count.store(0);
+        buffer->dropped = 0;
+        traces.buffers.push_back(buffer);
+    }
+    return buffer;
+} // threadBuffer
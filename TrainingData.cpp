@@ -0,0 +1,359 @@
+// File: TrainingData.cpp
+//   By: John Holik
+// Desc: Implementation of the training sample file
+
+#include "TrainingData.h"
+#include <chrono>
+#include <cstring>
+
+const size_t BLOCK_RAW_BYTES = DATASET_BLOCK_SAMPLES * sizeof(TrainingSample);
+
+// local functions
+static size_t compressBytes(const uint8_t raw[], size_t size, uint8_t out[], size_t limit);
+static bool expandBytes(const uint8_t data[], size_t size, uint8_t out[], size_t expected);
+
+
+// Samples
+// ------------------------------------------------------------
+
+/**
+ * Pack one placement into a sample
+ * @param board - board before the placement
+ * @param shape - shape placed
+ * @param next - next shape shown while placing it
+ * @param placement - where the shape went
+ * @param reward - lines cleared, or SAMPLE_TOPPED_OUT
+ * @param sample - receives the packed sample
+ */
+void packSample(const SearchBoard& board, Tetromino::ShapeType shape, Tetromino::ShapeType next,
+                const Placement& placement, int reward, TrainingSample& sample) {
+    std::memset(sample.board, 0, sizeof(sample.board));
+
+    int bit = 0;
+    for(int row = 0; row < GAME_ROWS; ++row){
+        uint32_t cells = (board.rows[row] & ROW_BOARD_BITS) >> COLLISION_PAD_LEFT;
+        for(int column = 0; column < GAME_COLUMNS; ++column, ++bit){
+            if((cells >> column) & 1u){
+                sample.board[bit / 8] |= uint8_t(1u << (bit % 8));
+            }
+        }
+    }
+
+    sample.shapes = uint8_t(shape | next << 3 | (placement.rotation & 3) << 6);
+    sample.column = uint8_t(placement.column + COLLISION_PAD_LEFT);
+    sample.outcome = uint8_t((placement.row & 31) | reward << 5);
+} // packSample
+
+/**
+ * Compress a full or partial block ready for the writer. Blocks that
+ * don't get smaller are kept raw.
+ * @param compress - false to always keep the block raw
+ */
+void SampleBlock::finish(bool compress) {
+    size_t rawBytes = samples * sizeof(TrainingSample);
+    header.samples = uint32_t(samples);
+
+    if(compress){
+        // XOR each sample with the one before, from the end so the
+        // previous sample is still intact
+        uint8_t* bytes = reinterpret_cast<uint8_t*>(raw);
+        for(size_t index = rawBytes; index-- > sizeof(TrainingSample); ){
+            bytes[index] ^= bytes[index - sizeof(TrainingSample)];
+        }
+
+        size_t packed = compressBytes(bytes, rawBytes, data, rawBytes);
+        if(packed > 0){
+            header.bytes = uint32_t(packed) | BLOCK_COMPRESSED;
+            return;
+        }
+
+        // undo the XOR, from the front this time
+        for(size_t index = sizeof(TrainingSample); index < rawBytes; ++index){
+            bytes[index] ^= bytes[index - sizeof(TrainingSample)];
+        }
+    }
+
+    std::memcpy(data, raw, rawBytes);
+    header.bytes = uint32_t(rawBytes);
+} // finish
+
+/**
+ * Turn a block back into samples
+ * @param header - header of the block
+ * @param data - bytes of the block
+ * @param samples - receives header.samples samples
+ * @return false if the block is damaged
+ */
+bool decodeBlock(const BlockHeader& header, const uint8_t data[], TrainingSample samples[]) {
+    size_t rawBytes = header.samples * sizeof(TrainingSample);
+    size_t bytes = header.bytes & ~BLOCK_COMPRESSED;
+    uint8_t* out = reinterpret_cast<uint8_t*>(samples);
+
+    if(header.samples > uint32_t(DATASET_BLOCK_SAMPLES) || bytes > BLOCK_RAW_BYTES){
+        return false;
+    }
+    if(!(header.bytes & BLOCK_COMPRESSED)){
+        if(bytes != rawBytes){
+            return false;
+        }
+        std::memcpy(out, data, rawBytes);
+        return true;
+    }
+
+    if(!expandBytes(data, bytes, out, rawBytes)){
+        return false;
+    }
+    for(size_t index = sizeof(TrainingSample); index < rawBytes; ++index){
+        out[index] ^= out[index - sizeof(TrainingSample)];
+    }
+    return true;
+} // decodeBlock
+
+
+// Writer
+// ------------------------------------------------------------
+
+/**
+ * Default constructor, call open() to start a file
+ */
+DatasetWriter::DatasetWriter()
+        : _file{nullptr}, _compress{true}, _blocks{nullptr},
+          _free{DATASET_QUEUE_BLOCKS}, _full{DATASET_QUEUE_BLOCKS},
+          _closing{false}, _samples{0}, _bytes{0} { }
+
+/**
+ * Destructor writes what is left and closes the file
+ */
+DatasetWriter::~DatasetWriter() {
+    close();
+}
+
+/**
+ * Create the file and start the writer thread
+ * @param path - file to create, replacing any existing file
+ * @param compress - compress blocks
+ * @return false if the file could not be created
+ */
+bool DatasetWriter::open(const std::string& path, bool compress) {
+    close();
+
+    _file = std::fopen(path.c_str(), "wb");
+    if(!_file){
+        return false;
+    }
+
+    DatasetHeader header{DATASET_MAGIC, DATASET_VERSION, uint32_t(sizeof(TrainingSample)),
+                         uint32_t(DATASET_BLOCK_SAMPLES)};
+    std::fwrite(&header, sizeof(header), 1, _file);
+    _bytes = sizeof(header);
+    _samples = 0;
+    _compress = compress;
+
+    _blocks = new SampleBlock[DATASET_QUEUE_BLOCKS];
+    for(int block = 0; block < DATASET_QUEUE_BLOCKS; ++block){
+        _free.tryPush(&_blocks[block]);
+    }
+
+    _closing = false;
+    _writer = std::thread(&DatasetWriter::writerLoop, this);
+    return true;
+} // open
+
+/**
+ * Wait for every submitted block to be written and close the file.
+ * Blocks taken but not submitted are lost.
+ */
+void DatasetWriter::close() {
+    if(!_file){
+        return;
+    }
+
+    _closing = true;
+    _writer.join();
+
+    std::fclose(_file);
+    _file = nullptr;
+
+    SampleBlock* block;
+    while(_free.tryPop(block)){ }
+    delete[] _blocks;
+    _blocks = nullptr;
+} // close
+
+/**
+ * Get an empty block to fill, waits while every block is in use
+ * @return block with no samples
+ */
+SampleBlock* DatasetWriter::takeBlock() {
+    SampleBlock* block = nullptr;
+    while(!_free.tryPop(block)){
+        std::this_thread::yield(); // the writer is behind
+    }
+    block->samples = 0;
+    return block;
+} // takeBlock
+
+/**
+ * Compress a filled block on this thread and queue it for the writer
+ * @param block - block from takeBlock()
+ */
+void DatasetWriter::submit(SampleBlock* block) {
+    block->finish(_compress);
+    while(!_full.tryPush(block)){
+        std::this_thread::yield();
+    }
+} // submit
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * Write finished blocks in the order they arrive until closed
+ */
+void DatasetWriter::writerLoop() {
+    while(true){
+        SampleBlock* block;
+        if(!_full.tryPop(block)){
+            if(_closing){
+                break; // close() is only called once producers are done
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+
+        size_t bytes = block->header.bytes & ~BLOCK_COMPRESSED;
+        std::fwrite(&block->header, sizeof(block->header), 1, _file);
+        std::fwrite(block->data, 1, bytes, _file);
+        _samples += block->header.samples;
+        _bytes += sizeof(block->header) + bytes;
+
+        _free.tryPush(block);
+    }
+} // writerLoop
+
+
+// Reader
+// ------------------------------------------------------------
+
+/**
+ * Default constructor, call open() to read a file
+ */
+DatasetReader::DatasetReader() : _file{nullptr}, _data{new uint8_t[BLOCK_RAW_BYTES]} { }
+
+/**
+ * Destructor closes the file
+ */
+DatasetReader::~DatasetReader() {
+    if(_file){
+        std::fclose(_file);
+    }
+    delete[] _data;
+}
+
+/**
+ * @param path - file written by a DatasetWriter
+ * @return false if the file is missing or has a different format
+ */
+bool DatasetReader::open(const std::string& path) {
+    if(_file){
+        std::fclose(_file);
+    }
+
+    _file = std::fopen(path.c_str(), "rb");
+    DatasetHeader header{};
+    if(!_file || std::fread(&header, sizeof(header), 1, _file) != 1 ||
+       header.magic != DATASET_MAGIC || header.version != DATASET_VERSION ||
+       header.sampleBytes != sizeof(TrainingSample) ||
+       header.blockSamples > uint32_t(DATASET_BLOCK_SAMPLES)){
+        return false;
+    }
+    return true;
+} // open
+
+/**
+ * @param samples - receives up to DATASET_BLOCK_SAMPLES samples
+ * @return samples read, 0 at the end of the file, -1 if it is damaged
+ */
+int DatasetReader::readBlock(TrainingSample samples[]) {
+    BlockHeader header{};
+    if(!_file || std::fread(&header, sizeof(header), 1, _file) != 1){
+        return 0;
+    }
+
+    size_t bytes = header.bytes & ~BLOCK_COMPRESSED;
+    if(bytes > BLOCK_RAW_BYTES || std::fread(_data, 1, bytes, _file) != bytes ||
+       !decodeBlock(header, _data, samples)){
+        return -1;
+    }
+    return int(header.samples);
+} // readBlock
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * Store runs of zero bytes as a zero followed by the run length,
+ * other bytes are copied
+ * @param raw - bytes to compress
+ * @param size - number of bytes
+ * @param out - receives the compressed bytes
+ * @param limit - give up once the output reaches this size
+ * @return compressed size, 0 if it would not be smaller than limit
+ */
+static size_t compressBytes(const uint8_t raw[], size_t size, uint8_t out[], size_t limit) {
+    size_t written = 0;
+    size_t index = 0;
+
+    while(index < size){
+        if(written + 2 > limit){
+            return 0;
+        }
+
+        if(raw[index] != 0){
+            out[written++] = raw[index++];
+            continue;
+        }
+
+        size_t run = 1;
+        while(index + run < size && raw[index + run] == 0 && run < 255){
+            ++run;
+        }
+        out[written++] = 0;
+        out[written++] = uint8_t(run);
+        index += run;
+    }
+    return written;
+} // compressBytes
+
+/**
+ * Undo compressBytes()
+ * @param data - compressed bytes
+ * @param size - number of compressed bytes
+ * @param out - receives the bytes
+ * @param expected - size the bytes must expand to
+ * @return false if the data doesn't expand to exactly expected bytes
+ */
+static bool expandBytes(const uint8_t data[], size_t size, uint8_t out[], size_t expected) {
+    size_t written = 0;
+    size_t index = 0;
+
+    while(index < size){
+        if(data[index] != 0){
+            if(written == expected){
+                return false;
+            }
+            out[written++] = data[index++];
+            continue;
+        }
+
+        if(index + 1 == size || data[index + 1] == 0 || written + data[index + 1] > expected){
+            return false;
+        }
+        std::memset(out + written, 0, data[index + 1]);
+        written += data[index + 1];
+        index += 2;
+    }
+    return written == expected;
+} // expandBytes
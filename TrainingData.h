@@ -0,0 +1,139 @@
+// File: TrainingData.h
+//   By: John Holik
+// Desc: Binary file of training samples, one fixed width record per
+//       placement: the board before it, the current and next shape,
+//       where the shape went and the lines it cleared. Samples are
+//       grouped in blocks that can be compressed: each sample is XORed
+//       with the one before it, which leaves mostly zero bytes since
+//       one placement changes little of the board, and runs of zero
+//       bytes are stored as a count.
+//
+//       Producers fill and compress blocks on their own threads and
+//       pass them through a lock-free queue to one writer thread, so
+//       the writer only ever copies finished blocks to the file.
+//
+//       file: [header][block header][block bytes][block header]...
+
+#ifndef TETRIS3_TRAININGDATA_H
+#define TETRIS3_TRAININGDATA_H
+#include "tetris.h"
+#include "SearchBoard.h"
+#include "LockFreeQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+const uint32_t DATASET_MAGIC = 0x53445454; // "TTDS"
+const uint32_t DATASET_VERSION = 1;
+const int DATASET_BLOCK_SAMPLES = 4096;    // samples per block
+const int DATASET_QUEUE_BLOCKS = 64;       // blocks in flight between threads
+const uint32_t BLOCK_COMPRESSED = 0x80000000u; // flag in BlockHeader::bytes
+
+// one bit per cell of the board
+const int SAMPLE_BOARD_BYTES = (GAME_ROWS * GAME_COLUMNS + 7) / 8;
+
+// reward of a placement after which the next shape can't spawn
+const int SAMPLE_TOPPED_OUT = 7;
+
+struct TrainingSample{
+    uint8_t board[SAMPLE_BOARD_BYTES]; // GAME_COLUMNS bits per row from row 0 up
+    uint8_t shapes;     // current shape bits 0-2, next bits 3-5, rotation bits 6-7
+    uint8_t column;     // grid column + COLLISION_PAD_LEFT
+    uint8_t outcome;    // row bits 0-4, lines cleared (or SAMPLE_TOPPED_OUT) bits 5-7
+};
+
+struct DatasetHeader{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sampleBytes; // sizeof(TrainingSample)
+    uint32_t blockSamples;
+};
+
+struct BlockHeader{
+    uint32_t samples;
+    uint32_t bytes;       // bytes that follow, BLOCK_COMPRESSED if compressed
+};
+
+struct SampleBlock{
+    int samples;
+    TrainingSample raw[DATASET_BLOCK_SAMPLES];
+
+    BlockHeader header;   // set by finish()
+    uint8_t data[DATASET_BLOCK_SAMPLES * sizeof(TrainingSample)];
+
+    void finish(bool compress);
+};
+
+// Samples
+// ------------------------------------------------------------
+void packSample(const SearchBoard& board, Tetromino::ShapeType shape, Tetromino::ShapeType next,
+                const Placement& placement, int reward, TrainingSample& sample);
+
+bool decodeBlock(const BlockHeader& header, const uint8_t data[], TrainingSample samples[]);
+
+
+class DatasetWriter {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    DatasetWriter();
+
+    ~DatasetWriter(); // destructor, closes the file
+
+    DatasetWriter(const DatasetWriter& other) = delete;
+    DatasetWriter& operator=(const DatasetWriter& rhs) = delete;
+
+    // Accessors
+    // --------------------------------------------------------
+    uint64_t getSamples() {return _samples;}
+    uint64_t getBytes() {return _bytes;}
+
+    // Methods
+    // --------------------------------------------------------
+    bool open(const std::string& path, bool compress);
+    void close();
+
+    SampleBlock* takeBlock();
+    void submit(SampleBlock* block);
+
+private:
+    std::FILE* _file;
+    bool _compress;
+
+    SampleBlock* _blocks;                  // every block, owned here
+    LockFreeQueue<SampleBlock*> _free;     // blocks producers can fill
+    LockFreeQueue<SampleBlock*> _full;     // blocks waiting to be written
+
+    std::thread _writer;
+    std::atomic<bool> _closing;
+    uint64_t _samples;                     // written so far
+    uint64_t _bytes;
+
+    void writerLoop();
+};
+
+
+class DatasetReader {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    DatasetReader();
+
+    ~DatasetReader(); // destructor, closes the file
+
+    DatasetReader(const DatasetReader& other) = delete;
+    DatasetReader& operator=(const DatasetReader& rhs) = delete;
+
+    // Methods
+    // --------------------------------------------------------
+    bool open(const std::string& path);
+    int readBlock(TrainingSample samples[]);
+
+private:
+    std::FILE* _file;
+    uint8_t* _data;     // bytes of the block being read
+};
+
+#endif //TETRIS3_TRAININGDATA_H
@@ -0,0 +1,198 @@
+// File: TranspositionTable.cpp
+//   By: John Holik
+// Desc: Implementation of the lock-free search result cache
+
+#include "TranspositionTable.h"
+#include <cstring>
+
+// data word: score bits 0-31, column 32-39, row 40-47,
+// rotation 48-49, depth 50-51, age 52-59
+const int DATA_COLUMN = 32;
+const int DATA_ROW = 40;
+const int DATA_ROTATION = 48;
+const int DATA_DEPTH = 50;
+const int DATA_AGE = 52;
+const int MAX_DEPTH = 3;
+
+// local functions
+static uint64_t mix(uint64_t bits);
+static uint64_t packData(const Placement& placement, float score, int depth, uint32_t age);
+static int dataDepth(uint64_t data);
+static int dataAge(uint64_t data);
+
+
+/**
+ * Property constructor, the table starts empty
+ * @param entries - entries to hold, rounded down to a power of two clusters
+ */
+TranspositionTable::TranspositionTable(int entries) : _age{0} {
+    uint64_t clusters = 1;
+    while(clusters * 2 * TABLE_CLUSTER <= uint64_t(entries)){
+        clusters *= 2;
+    }
+
+    _clusters = new Cluster[clusters];
+    _clusterMask = clusters - 1;
+    clear();
+} // property
+
+/**
+ * Destructor frees the entries
+ */
+TranspositionTable::~TranspositionTable() {
+    delete[] _clusters;
+}
+
+/**
+ * @param board - board before the shape is placed
+ * @param shape - shape to place
+ * @param next - next shape, SHAPE_NONE when the search doesn't know it
+ * @param third - shape after next, SHAPE_NONE when the search doesn't know it
+ * @return key of the position, never 0
+ */
+uint64_t TranspositionTable::key(const SearchBoard& board, Tetromino::ShapeType shape,
+                                 Tetromino::ShapeType next, Tetromino::ShapeType third) {
+    uint64_t hash = mix(uint64_t(third + 1) << 16 | uint64_t(shape + 1) << 8 | uint64_t(next + 1));
+    for(int row = 0; row < GAME_ROWS; ++row){
+        hash = mix(hash ^ board.rows[row]);
+    }
+    return hash | 1u;
+} // key
+
+/**
+ * Look up a position
+ * @param key - from key()
+ * @param depth - fewest levels the result must have searched
+ * @param hit - receives the stored result
+ * @return true if a deep enough result was found
+ */
+bool TranspositionTable::probe(uint64_t key, int depth, TableHit& hit) const {
+    const Cluster& cluster = _clusters[key & _clusterMask];
+
+    for(const Entry& entry : cluster.entries){
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        // a torn read from a racing store fails this test
+        if((check ^ data) != key){
+            continue;
+        }
+        if(dataDepth(data) < depth){
+            return false;
+        }
+
+        uint32_t scoreBits = uint32_t(data);
+        std::memcpy(&hit.score, &scoreBits, sizeof(hit.score));
+        // just the position, SearchBoard::route() finds any last move
+        hit.placement = Placement{int8_t((data >> DATA_ROTATION) & 3u), int8_t(data >> DATA_COLUMN),
+                                  int8_t(data >> DATA_ROW), 0, 0, 0};
+        hit.depth = dataDepth(data);
+        return true;
+    }
+    return false;
+} // probe
+
+/**
+ * Save a result. It replaces the same position unless that one was
+ * searched deeper this search, otherwise the cluster entry from the
+ * oldest search, and between equally old ones the shallowest
+ * @param key - from key()
+ * @param placement - best placement found
+ * @param score - its score
+ * @param depth - levels searched, 1 to 3
+ */
+void TranspositionTable::store(uint64_t key, const Placement& placement, float score, int depth) {
+    Cluster& cluster = _clusters[key & _clusterMask];
+    uint64_t data = packData(placement, score, depth, _age);
+
+    Entry* replace = nullptr;
+    int worst = 1 << 30;
+    for(Entry& entry : cluster.entries){
+        uint64_t old = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if((check ^ old) == key){
+            if(dataDepth(old) > depth && dataAge(old) == int(_age & 0xFFu)){
+                return; // already have a deeper result
+            }
+            replace = &entry;
+            break;
+        }
+
+        // older searches count for more than depth
+        int stale = (int(_age) - dataAge(old)) & 0xFF;
+        int worth = old == 0 ? -(1 << 30) : dataDepth(old) - stale * (MAX_DEPTH + 1);
+        if(worth < worst){
+            worst = worth;
+            replace = &entry;
+        }
+    }
+
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+} // store
+
+/**
+ * Start a new search, entries already stored become older than the
+ * ones it stores. Call it before the search's threads start.
+ */
+void TranspositionTable::newSearch() {
+    ++_age;
+}
+
+/**
+ * Remove every entry, needed when the weights the scores came from change
+ */
+void TranspositionTable::clear() {
+    for(uint64_t index = 0; index <= _clusterMask; ++index){
+        for(Entry& entry : _clusters[index].entries){
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+} // clear
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * splitmix64 finalizer
+ * @param bits - value to mix
+ * @return mixed bits
+ */
+static uint64_t mix(uint64_t bits) {
+    bits += 0x9E3779B97F4A7C15ull;
+    bits = (bits ^ (bits >> 30)) * 0xBF58476D1CE4E5B9ull;
+    bits = (bits ^ (bits >> 27)) * 0x94D049BB133111EBull;
+    return bits ^ (bits >> 31);
+}
+
+/**
+ * @return the data word of an entry
+ */
+static uint64_t packData(const Placement& placement, float score, int depth, uint32_t age) {
+    uint32_t scoreBits;
+    std::memcpy(&scoreBits, &score, sizeof(scoreBits));
+
+    return uint64_t(scoreBits) |
+           uint64_t(uint8_t(placement.column)) << DATA_COLUMN |
+           uint64_t(uint8_t(placement.row)) << DATA_ROW |
+           uint64_t(placement.rotation & 3) << DATA_ROTATION |
+           uint64_t(depth & MAX_DEPTH) << DATA_DEPTH |
+           uint64_t(age & 0xFFu) << DATA_AGE;
+}
+
+/**
+ * @return levels searched for the entry
+ */
+static int dataDepth(uint64_t data) {
+    return int((data >> DATA_DEPTH) & MAX_DEPTH);
+}
+
+/**
+ * @return low 8 bits of the search count the entry was stored in
+ */
+static int dataAge(uint64_t data) {
+    return int((data >> DATA_AGE) & 0xFFu);
+}
@@ -0,0 +1,71 @@
+// File: TranspositionTable.h
+//   By: John Holik
+// Desc: Cache of search results shared by every thread of a search.
+//       Entries are keyed by the board, the shape placed and the shapes
+//       known after it and hold the best placement and its score. Entries sit in
+//       clusters of four on one cache line. Each entry is two atomic
+//       words, the key xor the data and the data, so a read that races
+//       a write just fails the key check instead of needing a lock. A
+//       full cluster replaces the entry from the oldest search, then the
+//       shallowest one.
+
+#ifndef TETRIS3_TRANSPOSITIONTABLE_H
+#define TETRIS3_TRANSPOSITIONTABLE_H
+#include "SearchBoard.h"
+#include <atomic>
+#include <cstdint>
+
+const int TABLE_ENTRIES = 1 << 15;   // default size, 16 bytes an entry
+const int TABLE_CLUSTER = 4;         // entries sharing a cache line
+
+struct TableHit{
+    Placement placement;
+    float score;
+    int depth;     // levels searched below the placement
+};
+
+
+class TranspositionTable {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    explicit TranspositionTable(int entries = TABLE_ENTRIES);
+
+    ~TranspositionTable(); // destructor
+
+    TranspositionTable(const TranspositionTable& other) = delete;
+    TranspositionTable& operator=(const TranspositionTable& rhs) = delete;
+
+    // Accessors
+    // --------------------------------------------------------
+    int getEntries() {return int(_clusterMask + 1) * TABLE_CLUSTER;}
+
+    // Methods
+    // --------------------------------------------------------
+    static uint64_t key(const SearchBoard& board, Tetromino::ShapeType shape,
+                        Tetromino::ShapeType next,
+                        Tetromino::ShapeType third = Tetromino::SHAPE_NONE);
+
+    bool probe(uint64_t key, int depth, TableHit& hit) const;
+    void store(uint64_t key, const Placement& placement, float score, int depth);
+
+    void newSearch(); // ages the entries stored so far
+    void clear();
+
+private:
+    struct Entry{
+        std::atomic<uint64_t> check;  // key ^ data
+        std::atomic<uint64_t> data;   // packed placement, score, depth and age
+    };
+
+    struct alignas(64) Cluster{
+        Entry entries[TABLE_CLUSTER];
+    };
+
+    Cluster* _clusters;
+    uint64_t _clusterMask;
+    uint32_t _age;       // search count, only the low 8 bits are stored
+};
+
+
+#endif //TETRIS3_TRANSPOSITIONTABLE_H
@@ -0,0 +1,209 @@
+// File: VersusGame.cpp
+//   By: John Holik
+// Desc: Implementation of the local versus mode
+
+#include "VersusGame.h"
+#include "GameInput.h"
+#include <algorithm>
+
+// player 2 plays with the arrow keys, mapped onto the board's keys
+const sf::Keyboard::Key PLAYER2_KEYS[] = {sf::Keyboard::Key::Left, sf::Keyboard::Key::Right,
+                                          sf::Keyboard::Key::Down, sf::Keyboard::Key::Up};
+const sf::Keyboard::Key BOARD_KEYS[] = {sf::Keyboard::Key::A, sf::Keyboard::Key::D,
+                                        sf::Keyboard::Key::S, sf::Keyboard::Key::Space};
+
+/**
+ * Property constructor sets up the boards and starts the worker threads
+ * @param players - number of boards, at least 1
+ * @param humans - boards played from the keyboard (0-2), the rest are bots
+ * @param seed - every board gets the same sequence of shapes from this seed
+ * @param weights - evaluation weights of the bots
+ */
+VersusGame::VersusGame(int players, int humans, unsigned int seed, const EvalWeights& weights)
+        : _workerCount{countWorkers(players)},
+          _startTick{_workerCount + 1},
+          _endTick{_workerCount + 1},
+          _stopping{false},
+          _botPool{int(std::thread::hardware_concurrency())},
+          _randGenerator{seed} {
+    players = std::max(1, players); // the layout divides by the board count
+
+    for(int player = 0; player < players; ++player){
+        _boards.push_back(new TetrisBoard(seed));
+        _bots.push_back(player < humans ? nullptr : new TetrisBot(_botPool, weights));
+        _inputs.emplace_back(sf::Keyboard::KeyCount, KeyPressedState{false, false});
+        _finished.push_back(false);
+    }
+
+    for(int worker = 0; worker < _workerCount; ++worker){
+        _workers.emplace_back(&VersusGame::workerLoop, this, worker);
+    }
+} // property
+
+/**
+ * Destructor stops the workers and cleans up the boards
+ */
+VersusGame::~VersusGame() {
+    _stopping = true;
+    _startTick.wait(); // release the workers so they see the stop flag
+
+    for(std::thread& worker : _workers){
+        worker.join();
+    }
+
+    for(TetrisBoard* board : _boards){
+        delete board;
+    }
+    for(TetrisBot* bot : _bots){
+        delete bot;
+    }
+} // destructor
+
+/**
+ * @return window size needed to fit every board
+ */
+sf::Vector2u VersusGame::getWindowSize() {
+    int players = getPlayers();
+    int columns = std::min(players, VERSUS_MAX_COLUMNS);
+    int rows = (players + columns - 1) / columns;
+    float scale = players > 2 ? 0.5f : 1.f;
+
+    return sf::Vector2u(unsigned(columns * WIN_WIDTH * scale),
+                        unsigned(rows * WIN_HEIGHT * scale));
+} // getWindowSize
+
+/**
+ * Run one tick on every board, then exchange garbage between them
+ * @param input - keyboard state, player 1 uses the board keys and
+ *                player 2 the arrow keys
+ * @return true if the game should end
+ */
+bool VersusGame::Update(KeyPressedState input[]) {
+    int players = getPlayers();
+
+    // hand out this tick's keyboard input
+    if(!_bots[0]){
+        std::copy(input, input + sf::Keyboard::KeyCount, _inputs[0].begin());
+    }
+    if(players > 1 && !_bots[1]){
+        bindKeys(input, _inputs[1].data(), true);
+    }
+
+    _startTick.wait(); // workers update the boards
+    _endTick.wait();   // every board is done
+
+    // keep any key state changes made by the boards
+    if(!_bots[0]){
+        std::copy(_inputs[0].begin(), _inputs[0].end(), input);
+    }
+    if(players > 1 && !_bots[1]){
+        bindKeys(input, _inputs[1].data(), false);
+    }
+
+    // garbage is exchanged in board order so the result is the same
+    // no matter which thread finished first
+    int playing = 0;
+    for(int player = 0; player < players; ++player){
+        if(!_finished[player]){
+            sendGarbage(player, _boards[player]->getLastCleared());
+            ++playing;
+        }
+    }
+
+    return playing == 0 || (players > 1 && playing == 1);
+} // Update
+
+/**
+ * Draw each board in its own part of the window
+ * @param window - main game window
+ */
+void VersusGame::render(sf::RenderWindow& window) {
+    int players = getPlayers();
+    int columns = std::min(players, VERSUS_MAX_COLUMNS);
+    int rows = (players + columns - 1) / columns;
+
+    sf::View view{sf::FloatRect(0.f, 0.f, WIN_WIDTH, WIN_HEIGHT)};
+    for(int player = 0; player < players; ++player){
+        view.setViewport(sf::FloatRect(float(player % columns) / columns,
+                                       float(player / columns) / rows,
+                                       1.f / columns, 1.f / rows));
+        window.setView(view);
+        _boards[player]->render(window);
+    }
+
+    window.setView(window.getDefaultView());
+} // render
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * Update every board assigned to a worker once per tick
+ * @param worker - index of the worker, boards are dealt out round robin
+ */
+void VersusGame::workerLoop(int worker) {
+    int players = getPlayers();
+    BoardState state{};
+
+    while(true){
+        _startTick.wait();
+        if(_stopping){
+            break;
+        }
+
+        for(int player = worker; player < players; player += _workerCount){
+            if(_bots[player]){
+                _boards[player]->getState(state);
+                pressInputs(_bots[player]->nextInput(state), _inputs[player].data());
+            }
+            _finished[player] = _boards[player]->Update(_inputs[player].data());
+        }
+
+        _endTick.wait();
+    }
+} // workerLoop
+
+/**
+ * Send garbage rows for a multi-line clear to the next player still playing
+ * @param from - player that cleared the lines
+ * @param lines - number of lines cleared
+ */
+void VersusGame::sendGarbage(int from, int lines) {
+    int rows = GARBAGE_FOR_LINES[std::min(lines, 4)];
+    int players = getPlayers();
+
+    for(int next = 1; rows > 0 && next < players; ++next){
+        int target = (from + next) % players;
+        if(!_finished[target]){
+            std::uniform_int_distribution<> hole(0, GAME_COLUMNS - 1);
+            _boards[target]->addGarbage(rows, hole(_randGenerator));
+            rows = 0;
+        }
+    }
+} // sendGarbage
+
+/**
+ * Copy player 2's arrow keys to or from the board keys of their input
+ * @param input - keyboard state
+ * @param board - input of player 2's board
+ * @param toBoard - true to copy keyboard to board, false to copy back
+ */
+void VersusGame::bindKeys(KeyPressedState input[], KeyPressedState board[], bool toBoard) {
+    for(int key = 0; key < 4; ++key){
+        if(toBoard){
+            board[BOARD_KEYS[key]] = input[PLAYER2_KEYS[key]];
+        } else {
+            input[PLAYER2_KEYS[key]] = board[BOARD_KEYS[key]];
+        }
+    }
+} // bindKeys
+
+/**
+ * @param players - number of boards
+ * @return number of worker threads to use
+ */
+int VersusGame::countWorkers(int players) {
+    int cores = int(std::thread::hardware_concurrency());
+    return std::max(1, std::min(players, cores));
+} // countWorkers
@@ -0,0 +1,74 @@
+// File: VersusGame.h
+//   By: John Holik
+// Desc: Local versus mode. Several TetrisBoards run in lockstep, one
+//       update per tick, with the boards split across worker threads.
+//       Multi-line clears send garbage rows to the next player still
+//       in the game and the boards are drawn side by side. Boards not
+//       played from the keyboard are played by a TetrisBot.
+
+#ifndef TETRIS3_VERSUSGAME_H
+#define TETRIS3_VERSUSGAME_H
+#include "tetris.h"
+#include "TetrisBoard.h"
+#include "TickBarrier.h"
+#include "TetrisBot.h"
+#include "WorkStealingPool.h"
+#include <SFML/Graphics.hpp>
+#include <random>
+#include <thread>
+#include <vector>
+
+const int VERSUS_MAX_COLUMNS = 4; // boards per row of the window
+
+// garbage rows sent for clearing 0, 1, 2, 3 or 4 lines at once
+const int GARBAGE_FOR_LINES[] = {0, 0, 1, 2, 4};
+
+
+class VersusGame {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    VersusGame(int players, int humans, unsigned int seed,
+               const EvalWeights& weights = DEFAULT_WEIGHTS);
+
+    ~VersusGame(); // destructor
+
+    // Accessors
+    // --------------------------------------------------------
+    int getPlayers() {return int(_boards.size());}
+    sf::Vector2u getWindowSize();
+
+    // Methods
+    // --------------------------------------------------------
+    bool Update(KeyPressedState input[]);
+
+    void render(sf::RenderWindow& window);
+
+private:
+    std::vector<TetrisBoard*> _boards;
+    std::vector<TetrisBot*> _bots; // nullptr for boards played from the keyboard
+    std::vector<std::vector<KeyPressedState>> _inputs; // input per board
+    std::vector<char> _finished; // Update() result per board this tick
+
+    // worker threads update their share of the boards between the
+    // start and end barriers, the main thread waits on both
+    int _workerCount;
+    std::vector<std::thread> _workers;
+    TickBarrier _startTick;
+    TickBarrier _endTick;
+    bool _stopping;
+
+    // every bot searches on the same pool so they don't oversubscribe
+    WorkStealingPool _botPool;
+
+    // picks the open column of garbage rows
+    std::mt19937 _randGenerator;
+
+    void workerLoop(int worker);
+    void sendGarbage(int from, int lines);
+    void bindKeys(KeyPressedState input[], KeyPressedState board[], bool toBoard);
+    static int countWorkers(int players);
+};
+
+
+#endif //TETRIS3_VERSUSGAME_H
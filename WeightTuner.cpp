@@ -0,0 +1,287 @@
+// File: WeightTuner.cpp
+//   By: John Holik
+// Desc: Implementation of the evaluation weight tuner
+
+#include "WeightTuner.h"
+#include "TetrisBoard.h"
+#include "TetrisBot.h"
+#include "Trace.h"
+#include "GameInput.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <vector>
+
+const char* const CHECKPOINT_TAG = "tetris-tuner";
+const int CHECKPOINT_VERSION = 1;
+
+// local functions
+static EvalWeights toWeights(const float values[]);
+static void fromWeights(const EvalWeights& weights, float values[]);
+static bool readCheckpoint(const std::string& path, uint32_t& seed, int& generation,
+                           float mean[], float deviation[], float best[], float& bestFitness);
+
+
+/**
+ * Property constructor, starts from the default weights
+ * @param pool - threads to play games on
+ * @param checkpointPath - file progress is saved to and resumed from
+ * @param seed - seed for every game and sample of the run
+ */
+WeightTuner::WeightTuner(WorkStealingPool& pool, const std::string& checkpointPath, uint32_t seed)
+        : _pool{pool}, _path{checkpointPath}, _seed{seed}, _generation{0},
+          _best{DEFAULT_WEIGHTS}, _bestFitness{0.f} {
+    fromWeights(DEFAULT_WEIGHTS, _mean);
+    for(float& deviation : _deviation){
+        deviation = TUNER_START_DEVIATION;
+    }
+} // property
+
+/**
+ * Resume from the checkpoint file
+ * @return false if there is no usable checkpoint
+ */
+bool WeightTuner::loadCheckpoint() {
+    float best[TUNER_WEIGHTS];
+    if(!readCheckpoint(_path, _seed, _generation, _mean, _deviation, best, _bestFitness)){
+        return false;
+    }
+    _best = toWeights(best);
+    return true;
+} // loadCheckpoint
+
+/**
+ * Save progress, written to a temporary file first so a run stopped
+ * mid-save keeps the previous checkpoint
+ * @return false if the file can't be written
+ */
+bool WeightTuner::saveCheckpoint() {
+    std::string temporary = _path + ".tmp";
+    {
+        std::ofstream file(temporary);
+        file.precision(9);
+
+        float best[TUNER_WEIGHTS];
+        fromWeights(_best, best);
+
+        file << CHECKPOINT_TAG << ' ' << CHECKPOINT_VERSION << '\n'
+             << _seed << ' ' << _generation << ' ' << _bestFitness << '\n';
+        for(float value : _mean) file << value << ' ';
+        file << '\n';
+        for(float value : _deviation) file << value << ' ';
+        file << '\n';
+        for(float value : best) file << value << ' ';
+        file << '\n';
+
+        if(!file.flush()){
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), _path.c_str()) == 0;
+} // saveCheckpoint
+
+/**
+ * Sample a population, play its games and move the mean and spread
+ * toward the best candidates
+ * @param report - receives one line about the generation
+ */
+void WeightTuner::runGeneration(std::ostream& report) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::seed_seq sequence{_seed, uint32_t(_generation)};
+    std::mt19937 generator(sequence);
+    std::normal_distribution<float> normal(0.f, 1.f);
+
+    // candidate 0 is the mean itself, the rest are samples around it,
+    // all scaled to unit length since only the weights' ratios matter
+    float candidates[TUNER_POPULATION][TUNER_WEIGHTS];
+    for(int candidate = 0; candidate < TUNER_POPULATION; ++candidate){
+        float length = 0.f;
+        for(int weight = 0; weight < TUNER_WEIGHTS; ++weight){
+            float value = _mean[weight];
+            if(candidate > 0){
+                value += _deviation[weight] * normal(generator);
+            }
+            candidates[candidate][weight] = value;
+            length += value * value;
+        }
+        length = std::sqrt(length);
+        for(int weight = 0; weight < TUNER_WEIGHTS && length > 0.f; ++weight){
+            candidates[candidate][weight] /= length;
+        }
+    }
+
+    // every candidate plays the same games
+    int games = TUNER_POPULATION * TUNER_GAMES;
+    std::vector<int> lines(games);
+    uint32_t firstGame = _seed + uint32_t(_generation) * TUNER_GAMES;
+
+    auto play = [&](int task) {
+        int candidate = task / TUNER_GAMES;
+        int game = task % TUNER_GAMES;
+        lines[task] = playGame(_pool, toWeights(candidates[candidate]),
+                               firstGame + uint32_t(game), TUNER_SHAPES);
+    };
+    _pool.run(games, play);
+
+    float fitness[TUNER_POPULATION];
+    int order[TUNER_POPULATION];
+    float total = 0.f;
+    for(int candidate = 0; candidate < TUNER_POPULATION; ++candidate){
+        int sum = 0;
+        for(int game = 0; game < TUNER_GAMES; ++game){
+            sum += lines[candidate * TUNER_GAMES + game];
+        }
+        fitness[candidate] = float(sum) / TUNER_GAMES;
+        order[candidate] = candidate;
+        total += fitness[candidate];
+    }
+    std::stable_sort(order, order + TUNER_POPULATION,
+                     [&](int lhs, int rhs) {return fitness[lhs] > fitness[rhs];});
+
+    // the next generation samples around the elite
+    for(int weight = 0; weight < TUNER_WEIGHTS; ++weight){
+        float mean = 0.f;
+        for(int elite = 0; elite < TUNER_ELITE; ++elite){
+            mean += candidates[order[elite]][weight];
+        }
+        mean /= TUNER_ELITE;
+
+        float variance = 0.f;
+        for(int elite = 0; elite < TUNER_ELITE; ++elite){
+            float difference = candidates[order[elite]][weight] - mean;
+            variance += difference * difference;
+        }
+        _mean[weight] = mean;
+        _deviation[weight] = std::sqrt(variance / TUNER_ELITE) + TUNER_MIN_DEVIATION;
+    }
+
+    float generationBest = fitness[order[0]];
+    if(generationBest > _bestFitness){
+        _bestFitness = generationBest;
+        _best = toWeights(candidates[order[0]]);
+    }
+    ++_generation;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const float* best = candidates[order[0]];
+    report << "generation " << _generation << ": best " << generationBest
+           << " mean " << total / TUNER_POPULATION << " lines, "
+           << games << " games in " << seconds << " s (" << games / seconds << " games/s)"
+           << ", weights " << best[0] << ' ' << best[1] << ' ' << best[2] << ' ' << best[3]
+           << std::endl;
+} // runGeneration
+
+/**
+ * Play one headless game with a bot, frame by frame like the window does
+ * @param pool - threads for the bot's search
+ * @param weights - bot evaluation weights
+ * @param seed - board seed, picks the shapes
+ * @param shapes - shapes to play before stopping
+ * @return lines cleared before the game ended or stopped
+ */
+int WeightTuner::playGame(WorkStealingPool& pool, const EvalWeights& weights,
+                          uint32_t seed, int shapes) {
+    TRACE_SCOPE("WeightTuner::playGame");
+    TetrisBoard board{seed};
+    TetrisBot bot{pool, weights};
+    bot.setMaxDepth(TUNER_SEARCH_DEPTH);
+
+    std::vector<KeyPressedState> keys(sf::Keyboard::KeyCount, KeyPressedState{false, false});
+    BoardState state{};
+
+    bool gameover = false;
+    while(!gameover){
+        board.getState(state);
+        if(state.shapesGenerated > uint32_t(shapes)){
+            break;
+        }
+        pressInputs(bot.nextInput(state), keys.data());
+        gameover = board.Update(keys.data());
+    }
+    return board.getLinesCleared();
+} // playGame
+
+/**
+ * Read only the best weights of a checkpoint, for the bot of the game
+ * @param checkpointPath - checkpoint written by a tuner
+ * @param weights - receives the best weights
+ * @return false if the file is not a usable checkpoint
+ */
+bool WeightTuner::readBestWeights(const std::string& checkpointPath, EvalWeights& weights) {
+    uint32_t seed;
+    int generation;
+    float mean[TUNER_WEIGHTS];
+    float deviation[TUNER_WEIGHTS];
+    float best[TUNER_WEIGHTS];
+    float bestFitness;
+    if(!readCheckpoint(checkpointPath, seed, generation, mean, deviation, best, bestFitness)){
+        return false;
+    }
+    weights = toWeights(best);
+    return true;
+} // readBestWeights
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * @param values - height, lines, holes and bumpiness weights
+ * @return the weights as EvalWeights
+ */
+static EvalWeights toWeights(const float values[]) {
+    return EvalWeights{values[0], values[1], values[2], values[3]};
+}
+
+/**
+ * @param weights - weights to split up
+ * @param values - receives height, lines, holes and bumpiness
+ */
+static void fromWeights(const EvalWeights& weights, float values[]) {
+    values[0] = weights.height;
+    values[1] = weights.lines;
+    values[2] = weights.holes;
+    values[3] = weights.bumpiness;
+}
+
+/**
+ * Parse a checkpoint, the outputs are only changed if all of it is read
+ * @param path - checkpoint file
+ * @return false if the file is missing or not a checkpoint
+ */
+static bool readCheckpoint(const std::string& path, uint32_t& seed, int& generation,
+                           float mean[], float deviation[], float best[], float& bestFitness) {
+    std::ifstream file(path);
+    std::string tag;
+    int version = 0;
+    if(!(file >> tag >> version) || tag != CHECKPOINT_TAG || version != CHECKPOINT_VERSION){
+        return false;
+    }
+
+    uint32_t fileSeed = 0;
+    int fileGeneration = 0;
+    float fileFitness = 0.f;
+    float values[3][TUNER_WEIGHTS];
+
+    file >> fileSeed >> fileGeneration >> fileFitness;
+    for(auto& row : values){
+        for(float& value : row){
+            file >> value;
+        }
+    }
+    if(!file){
+        return false;
+    }
+
+    seed = fileSeed;
+    generation = fileGeneration;
+    bestFitness = fileFitness;
+    std::copy(values[0], values[0] + TUNER_WEIGHTS, mean);
+    std::copy(values[1], values[1] + TUNER_WEIGHTS, deviation);
+    std::copy(values[2], values[2] + TUNER_WEIGHTS, best);
+    return true;
+}
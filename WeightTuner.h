@@ -0,0 +1,72 @@
+// File: WeightTuner.h
+//   By: John Holik
+// Desc: Tunes the bot's evaluation weights with the cross-entropy
+//       method. Each generation samples a population of weights around
+//       a mean, every candidate plays the same headless games (a real
+//       TetrisBoard driven by a TetrisBot, so the rules are exactly the
+//       windowed game's) and the mean and spread move toward the best
+//       candidates. Games run in parallel on a WorkStealingPool. Every
+//       random choice comes from the seed and generation number, so a
+//       run resumed from its checkpoint continues exactly as it would
+//       have without stopping.
+
+#ifndef TETRIS3_WEIGHTTUNER_H
+#define TETRIS3_WEIGHTTUNER_H
+#include "tetris.h"
+#include "SearchBoard.h"
+#include "WorkStealingPool.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+const int TUNER_WEIGHTS = 4;        // values in EvalWeights
+const int TUNER_POPULATION = 24;    // candidates per generation
+const int TUNER_ELITE = 6;          // best candidates the next generation follows
+const int TUNER_GAMES = 4;          // games each candidate plays per generation
+const int TUNER_SHAPES = 1000;      // shapes played before a game is scored
+const int TUNER_SEARCH_DEPTH = 1;   // bot search depth, below 3 is repeatable
+const float TUNER_START_DEVIATION = 0.5f; // spread of the first generation
+const float TUNER_MIN_DEVIATION = 0.02f; // keeps the search from collapsing
+const uint32_t TUNER_SEED = 20240901u;
+
+
+class WeightTuner {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    WeightTuner(WorkStealingPool& pool, const std::string& checkpointPath,
+                uint32_t seed = TUNER_SEED);
+
+    // Accessors
+    // --------------------------------------------------------
+    int getGeneration() {return _generation;}
+    const EvalWeights& getBest() {return _best;}
+    float getBestFitness() {return _bestFitness;}
+
+    // Methods
+    // --------------------------------------------------------
+    bool loadCheckpoint();
+    bool saveCheckpoint();
+
+    void runGeneration(std::ostream& report);
+
+    static int playGame(WorkStealingPool& pool, const EvalWeights& weights,
+                        uint32_t seed, int shapes);
+
+    static bool readBestWeights(const std::string& checkpointPath, EvalWeights& weights);
+
+private:
+    WorkStealingPool& _pool;
+    std::string _path;
+    uint32_t _seed;
+
+    int _generation;                     // generations finished
+    float _mean[TUNER_WEIGHTS];
+    float _deviation[TUNER_WEIGHTS];
+
+    EvalWeights _best;                   // best candidate seen so far
+    float _bestFitness;
+};
+
+
+#endif //TETRIS3_WEIGHTTUNER_H
@@ -0,0 +1,231 @@
+// File: WideBenchmark.cpp
+//   By: John Holik
+// Desc: Implementation of the wide board benchmark
+
+#include "WideBenchmark.h"
+#include "WideBoard.h"
+#include "TetrisBoard.h"
+#include "PieceSet.h"
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+// board sizes timed by runWideBenchmark(), columns then rows
+const int WIDE_BENCH_SIZES[][2] = {
+        {10, 21}, {16, 40}, {32, 100}, {64, 200}, {64, 500}, {64, WIDE_MAX_ROWS}};
+
+// share of cells filled in the lower half of a benchmark board
+const int WIDE_BENCH_FILL_PERCENT = 60;
+
+struct BenchQuery{
+    int shape;
+    int rotation;
+    int column;
+    int row;
+};
+
+// local functions
+static std::vector<BenchQuery> makeQueries(int columns, int rows, int count, std::mt19937& generator);
+static double elapsedNs(std::chrono::steady_clock::time_point start, int count);
+
+
+/**
+ * Time each board operation on one board size
+ * @param columns - board width
+ * @param rows - board height
+ * @param iterations - calls timed for each operation
+ * @return average time of each operation
+ */
+WideBenchResult benchmarkWideBoard(int columns, int rows, int iterations) {
+    std::mt19937 generator(1);
+    WideBoard board{columns, rows};
+    WideBenchResult result{board.getColumns(), board.getRows(),
+                           size_t(board.getRows()) * (sizeof(uint64_t) + size_t(board.getColumns())),
+                           0.0, 0.0, 0.0, 0.0};
+    columns = board.getColumns();
+    rows = board.getRows();
+
+    // single cell shape to fill the board with
+    ShapeMask cell{};
+    cell.rows = 1;
+    cell.columns = 1;
+    cell.bits[0] = 1u;
+
+    // fill the lower half
+    for(int row = 0; row < rows / 2; ++row){
+        for(int column = 0; column < columns; ++column){
+            if(int(generator() % 100) < WIDE_BENCH_FILL_PERCENT){
+                board.lockShape(cell, column, row, CELL_GARBAGE);
+            }
+        }
+    }
+
+    std::vector<BenchQuery> queries = makeQueries(columns, rows, iterations, generator);
+    volatile int sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    int hits = 0;
+    for(const BenchQuery& query : queries){
+        hits += board.hasCollision(shapeMask(Tetromino::ShapeType(query.shape), query.rotation),
+                                   query.column, query.row);
+    }
+    result.collisionNs = elapsedNs(start, iterations);
+    sink = hits;
+
+    // drops start at the top row and fall through the empty upper half
+    start = std::chrono::steady_clock::now();
+    int fallen = 0;
+    for(const BenchQuery& query : queries){
+        fallen += board.dropDistance(shapeMask(Tetromino::ShapeType(query.shape), query.rotation),
+                                     query.column, rows - 1, rows);
+    }
+    result.dropNs = elapsedNs(start, iterations);
+    sink = fallen;
+
+    // locks go at the query places on an empty board, overlaps don't
+    // change what a lock costs
+    WideBoard locked{columns, rows};
+    start = std::chrono::steady_clock::now();
+    for(const BenchQuery& query : queries){
+        locked.lockShape(shapeMask(Tetromino::ShapeType(query.shape), query.rotation),
+                         query.column, query.row, query.shape + 1);
+    }
+    result.lockNs = elapsedNs(start, iterations);
+
+    // clears take out four full rows from the bottom of a full board
+    double clearTotal = 0.0;
+    int clears = std::max(1, iterations / 100);
+    for(int clear = 0; clear < clears; ++clear){
+        locked.clear();
+        for(int row = 0; row < rows; ++row){
+            for(int column = 0; column < columns; ++column){
+                if(row >= 4 && column == row % columns){
+                    continue; // a hole so only the bottom rows are full
+                }
+                locked.lockShape(cell, column, row, CELL_GARBAGE);
+            }
+        }
+
+        start = std::chrono::steady_clock::now();
+        sink = locked.clearLines();
+        clearTotal += elapsedNs(start, 1);
+    }
+    result.clearNs = clearTotal / clears;
+
+    (void)sink;
+    return result;
+} // benchmarkWideBoard
+
+
+/**
+ * Time the collision and drop kernels of the standard board
+ * (see Collision.h) the same way, for comparison
+ * @param iterations - calls timed for each operation
+ * @return average time of each operation, no lock or clear times
+ */
+WideBenchResult benchmarkStandardBoard(int iterations) {
+    std::mt19937 generator(1);
+    WideBenchResult result{GAME_COLUMNS, GAME_ROWS, sizeof(TetrisBoard), 0.0, 0.0, 0.0, 0.0};
+
+    uint32_t rowMasks[GAME_ROWS];
+    for(int row = 0; row < GAME_ROWS; ++row){
+        rowMasks[row] = ROW_EMPTY;
+        for(int column = 0; row < GAME_ROWS / 2 && column < GAME_COLUMNS; ++column){
+            if(int(generator() % 100) < WIDE_BENCH_FILL_PERCENT){
+                rowMasks[row] |= 1u << (column + COLLISION_PAD_LEFT);
+            }
+        }
+    }
+
+    std::vector<BenchQuery> queries = makeQueries(GAME_COLUMNS, GAME_ROWS, iterations, generator);
+    volatile int sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    int hits = 0;
+    for(const BenchQuery& query : queries){
+        hits += hasCollision(rowMasks, shapeMask(Tetromino::ShapeType(query.shape), query.rotation),
+                             query.column, query.row);
+    }
+    result.collisionNs = elapsedNs(start, iterations);
+    sink = hits;
+
+    start = std::chrono::steady_clock::now();
+    int fallen = 0;
+    for(const BenchQuery& query : queries){
+        fallen += dropDistance(rowMasks, shapeMask(Tetromino::ShapeType(query.shape), query.rotation),
+                               query.column, GAME_ROWS - 1, GAME_ROWS);
+    }
+    result.dropNs = elapsedNs(start, iterations);
+    sink = fallen;
+
+    (void)sink;
+    return result;
+} // benchmarkStandardBoard
+
+
+/**
+ * Benchmark every size in WIDE_BENCH_SIZES and print a table
+ * @param iterations - calls timed for each operation
+ * @param out - stream to print to
+ */
+void runWideBenchmark(int iterations, std::ostream& out) {
+    std::vector<WideBenchResult> results;
+    results.push_back(benchmarkStandardBoard(iterations));
+    for(const auto& size : WIDE_BENCH_SIZES){
+        results.push_back(benchmarkWideBoard(size[0], size[1], iterations));
+    }
+
+    out << "board        state bytes  collision ns  drop ns  lock ns  clear ns" << std::endl;
+    for(size_t index = 0; index < results.size(); ++index){
+        const WideBenchResult& result = results[index];
+        std::string name = (index == 0 ? "std " : "wide ") + std::to_string(result.columns) +
+                           "x" + std::to_string(result.rows);
+
+        out << std::left << std::setw(13) << name << std::right
+            << std::setw(11) << result.stateBytes
+            << std::fixed << std::setprecision(1)
+            << std::setw(14) << result.collisionNs
+            << std::setw(9) << result.dropNs;
+        if(index == 0){
+            out << std::setw(9) << "-" << std::setw(10) << "-";
+        } else {
+            out << std::setw(9) << result.lockNs << std::setw(10) << result.clearNs;
+        }
+        out << std::endl;
+    }
+} // runWideBenchmark
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * Random shapes at random places, on the board or partly off its sides
+ * @param columns - board width
+ * @param rows - board height
+ * @param count - queries to make
+ * @param generator - random numbers
+ * @return queries
+ */
+static std::vector<BenchQuery> makeQueries(int columns, int rows, int count, std::mt19937& generator) {
+    std::vector<BenchQuery> queries(size_t(std::max(count, 1)));
+    for(BenchQuery& query : queries){
+        query.shape = int(generator() % unsigned(pieceSet().getCount()));
+        query.rotation = int(generator() % 4);
+        query.column = int(generator() % unsigned(columns)) - 1;
+        query.row = int(generator() % unsigned(rows));
+    }
+    return queries;
+}
+
+/**
+ * @param start - time the calls started
+ * @param count - calls made
+ * @return average nanoseconds per call
+ */
+static double elapsedNs(std::chrono::steady_clock::time_point start, int count) {
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / std::max(count, 1);
+}
@@ -0,0 +1,29 @@
+// File: WideBenchmark.h
+//   By: John Holik
+// Desc: Times the board operations of WideBoard at growing board sizes,
+//       collision tests, drops, locking and line clears, next to the
+//       standard 10 x 21 board, so the cost of a large board variant
+//       can be seen before it is played.
+
+#ifndef TETRIS3_WIDEBENCHMARK_H
+#define TETRIS3_WIDEBENCHMARK_H
+#include "tetris.h"
+#include <cstddef>
+#include <ostream>
+
+struct WideBenchResult{
+    int columns;
+    int rows;
+    size_t stateBytes;   // memory for the cells of the board
+    double collisionNs;  // per hasCollision()
+    double dropNs;       // per dropDistance() from the top
+    double lockNs;       // per lockShape()
+    double clearNs;      // per clearLines() with four full rows
+};
+
+WideBenchResult benchmarkWideBoard(int columns, int rows, int iterations);
+WideBenchResult benchmarkStandardBoard(int iterations);
+
+void runWideBenchmark(int iterations, std::ostream& out);
+
+#endif //TETRIS3_WIDEBENCHMARK_H
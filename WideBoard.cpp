@@ -0,0 +1,275 @@
+// File: WideBoard.cpp
+//   By: John Holik
+// Desc: Implementation of the wide game board
+
+#include "WideBoard.h"
+#include "TetrisBoard.h"
+#include "BoardState.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+
+// local functions
+static void addBlock(sf::VertexArray& vertices, sf::Vector2f topLeft, float size, sf::Color color);
+
+
+// Constructors
+// ------------------------------------------------------------
+
+/**
+ * Property constructor makes an empty board
+ * @param columns - board width, 1 to WIDE_MAX_COLUMNS
+ * @param rows - board height, 1 to WIDE_MAX_ROWS
+ */
+WideBoard::WideBoard(int columns, int rows) {
+    _columns = std::max(1, std::min(columns, WIDE_MAX_COLUMNS));
+    _rows = std::max(1, std::min(rows, WIDE_MAX_ROWS));
+    _fullRow = _columns == 64 ? ~uint64_t(0) : (uint64_t(1) << _columns) - 1u;
+
+    _rowMasks = new uint64_t[_rows];
+    _colors = new uint8_t[_rows * _columns];
+    _vertices.setPrimitiveType(sf::Triangles);
+
+    clear();
+} // property
+
+/**
+ * Destructor frees the rows
+ */
+WideBoard::~WideBoard() {
+    delete[] _rowMasks;
+    _rowMasks = nullptr;
+
+    delete[] _colors;
+    _colors = nullptr;
+}
+
+
+// Methods
+// ------------------------------------------------------------
+
+/**
+ * Same test as ::hasCollision() for the standard board, a block collides
+ * if it is outside the walls, below the floor or on a filled cell
+ * @param mask - shape to test
+ * @param column - column of the shape's left side
+ * @param row - row of the shape's top row
+ * @param overlay - more cells to collide with by row, such as shapes
+ *                  still moving, nullptr for just the filled cells
+ * @return true if there is a collision
+ */
+bool WideBoard::hasCollision(const ShapeMask& mask, int column, int row,
+                             const uint64_t overlay[]) const {
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        int gridRow = row - shapeRow;
+        uint64_t placed = 0;
+
+        if(!placeRow(mask.bits[shapeRow], column, placed) ||
+           (placed && gridRow < 0)){
+            return true;
+        }
+        if(gridRow >= 0 && gridRow < _rows){
+            uint64_t filled = overlay ? _rowMasks[gridRow] | overlay[gridRow] : _rowMasks[gridRow];
+            if(placed & filled){
+                return true;
+            }
+        }
+    } // each shape row
+    return false;
+} // hasCollision
+
+
+/**
+ * Find how far a shape falls. Above the stack it falls without testing,
+ * from there the shape's rows are placed once and tested against each
+ * row down the board with a mask per shape row.
+ * @param mask - shape to drop, must fit at column and row
+ * @param column - column of the shape's left side
+ * @param row - row of the shape's top row
+ * @param maxRows - most rows to fall
+ * @return rows the shape can fall, 0 .. maxRows
+ */
+int WideBoard::dropDistance(const ShapeMask& mask, int column, int row, int maxRows) const {
+    uint64_t placed[SHAPE_MAX_SIZE] = {0};
+    int bottom = 0; // lowest shape row with a block
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        placeRow(mask.bits[shapeRow], column, placed[shapeRow]);
+        if(placed[shapeRow]){
+            bottom = shapeRow;
+        }
+    }
+
+    // nothing is filled above the stack
+    int fall = std::max(0, std::min(row - bottom - _height, maxRows));
+    while(fall < maxRows && row - bottom - fall - 1 >= 0){
+        int top = row - fall - 1; // grid row of the shape's top row one lower
+        uint64_t collide = 0;
+        for(int shapeRow = 0; shapeRow <= bottom; ++shapeRow){
+            int gridRow = top - shapeRow;
+            if(gridRow < _rows){
+                collide |= placed[shapeRow] & _rowMasks[gridRow];
+            }
+        }
+        if(collide){
+            break;
+        }
+        ++fall;
+    } // each row down
+
+    return fall;
+} // dropDistance
+
+
+/**
+ * Fill the cells under a shape
+ * @param mask - shape to lock
+ * @param column - column of the shape's left side
+ * @param row - row of the shape's top row
+ * @param color - cell color index, see BoardState.h
+ */
+void WideBoard::lockShape(const ShapeMask& mask, int column, int row, int color) {
+    for(int shapeRow = 0; shapeRow < mask.rows; ++shapeRow){
+        int gridRow = row - shapeRow;
+        uint64_t placed = 0;
+        if(gridRow < 0 || gridRow >= _rows || !placeRow(mask.bits[shapeRow], column, placed)){
+            continue;
+        }
+
+        _rowMasks[gridRow] |= placed;
+        _height = std::max(_height, gridRow + 1);
+        while(placed){
+            int gridColumn = __builtin_ctzll(placed);
+            placed &= placed - 1u;
+            _colors[gridRow * _columns + gridColumn] = uint8_t(color);
+        }
+    } // each shape row
+} // lockShape
+
+
+/**
+ * Remove full rows and move the rows above them down
+ * @return number of rows removed
+ */
+int WideBoard::clearLines() {
+    TRACE_SCOPE("WideBoard::clearLines");
+    int cleared = 0;
+
+    for(int row = 0; row < _height; ++row){
+        if(_rowMasks[row] == _fullRow){
+            ++cleared; // skip the full row
+        } else if(cleared > 0){
+            _rowMasks[row - cleared] = _rowMasks[row];
+            std::memcpy(_colors + (row - cleared) * _columns, _colors + row * _columns, size_t(_columns));
+        }
+    } // each row bottom up
+
+    // rows left at the top of the stack are now empty
+    for(int row = _height - cleared; row < _height; ++row){
+        _rowMasks[row] = 0;
+        std::memset(_colors + row * _columns, CELL_EMPTY, size_t(_columns));
+    }
+    _height -= cleared;
+
+    return cleared;
+} // clearLines
+
+
+/**
+ * Empty every cell
+ */
+void WideBoard::clear() {
+    std::fill(_rowMasks, _rowMasks + _rows, uint64_t(0));
+    _height = 0;
+    std::memset(_colors, CELL_EMPTY, size_t(_rows * _columns));
+} // clear
+
+
+/**
+ * Draw the board with one draw call, the background and then each
+ * filled cell as two triangles
+ * @param window - window to draw on
+ * @param position - screen position of the board's top left
+ * @param blockSize - size of a cell in pixels
+ */
+void WideBoard::render(sf::RenderWindow& window, sf::Vector2f position, float blockSize) {
+    TRACE_SCOPE("WideBoard::render");
+    _vertices.clear();
+
+    sf::Vector2f size{_columns * blockSize, _rows * blockSize};
+    _vertices.append(sf::Vertex(position, BACKGROUND_COLOR));
+    _vertices.append(sf::Vertex(sf::Vector2f(position.x + size.x, position.y), BACKGROUND_COLOR));
+    _vertices.append(sf::Vertex(sf::Vector2f(position.x, position.y + size.y), BACKGROUND_COLOR));
+    _vertices.append(sf::Vertex(sf::Vector2f(position.x + size.x, position.y), BACKGROUND_COLOR));
+    _vertices.append(sf::Vertex(position + size, BACKGROUND_COLOR));
+    _vertices.append(sf::Vertex(sf::Vector2f(position.x, position.y + size.y), BACKGROUND_COLOR));
+
+    for(int row = 0; row < _height; ++row){
+        uint64_t filled = _rowMasks[row];
+        float top = position.y + (_rows - 1 - row) * blockSize;
+
+        while(filled){
+            int column = __builtin_ctzll(filled);
+            filled &= filled - 1u;
+            addBlock(_vertices, sf::Vector2f(position.x + column * blockSize, top), blockSize,
+                     cellColor(_colors[row * _columns + column]));
+        }
+    } // each row
+
+    window.draw(_vertices);
+} // render
+
+
+/**
+ * Move one row of a shape to its column on the board
+ * @param bits - shape row, bit c set = block in column c
+ * @param column - board column of the shape's left side
+ * @param placed - receives the blocks as a board row mask
+ * @return false if a block is outside the walls
+ */
+bool WideBoard::placeRow(uint32_t bits, int column, uint64_t& placed) const {
+    placed = 0;
+    if(bits == 0){
+        return true;
+    }
+    if(column <= -SHAPE_MAX_SIZE || column >= _columns){
+        return false;
+    }
+
+    if(column < 0){
+        if(bits & ((1u << -column) - 1u)){
+            return false; // in the left wall
+        }
+        bits >>= -column;
+        column = 0;
+    }
+    if(column + 32 - __builtin_clz(bits) > _columns){
+        return false; // in the right wall
+    }
+
+    placed = uint64_t(bits) << column;
+    return true;
+} // placeRow
+
+
+// Local functions
+// ------------------------------------------------------------
+
+/**
+ * Add a square cell to a triangle list
+ * @param vertices - triangle list
+ * @param topLeft - screen position of the cell
+ * @param size - cell size in pixels
+ * @param color - fill color
+ */
+static void addBlock(sf::VertexArray& vertices, sf::Vector2f topLeft, float size, sf::Color color) {
+    sf::Vector2f topRight{topLeft.x + size, topLeft.y};
+    sf::Vector2f bottomLeft{topLeft.x, topLeft.y + size};
+    sf::Vector2f bottomRight{topLeft.x + size, topLeft.y + size};
+
+    vertices.append(sf::Vertex(topLeft, color));
+    vertices.append(sf::Vertex(topRight, color));
+    vertices.append(sf::Vertex(bottomLeft, color));
+    vertices.append(sf::Vertex(topRight, color));
+    vertices.append(sf::Vertex(bottomRight, color));
+    vertices.append(sf::Vertex(bottomLeft, color));
+}
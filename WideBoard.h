@@ -0,0 +1,69 @@
+// File: WideBoard.h
+//   By: John Holik
+// Desc: Game board of any size up to 64 columns and WIDE_MAX_ROWS rows
+//       for large board variants. Each row is a single 64 bit mask of
+//       its filled cells plus a byte of color per cell, so a board of
+//       a few hundred rows is a few kilobytes and is drawn in one call
+//       from a vertex array instead of a RectangleShape per cell.
+
+#ifndef TETRIS3_WIDEBOARD_H
+#define TETRIS3_WIDEBOARD_H
+#include "tetris.h"
+#include "Collision.h"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+
+const int WIDE_MAX_COLUMNS = 64;
+const int WIDE_MAX_ROWS = 1024;
+
+class WideBoard {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    WideBoard(int columns, int rows);
+
+    ~WideBoard(); // destructor
+
+    WideBoard(const WideBoard& other) = delete;
+    WideBoard& operator=(const WideBoard& rhs) = delete;
+
+    // Accessors
+    // --------------------------------------------------------
+    int getColumns() const {return _columns;}
+    int getRows() const {return _rows;}
+    int getHeight() const {return _height;}
+
+    // filled cells of a row, column 0 in bit 0
+    uint64_t getRowMask(int row) const {return _rowMasks[row];}
+
+    int getColor(int row, int column) const {return _colors[row * _columns + column];}
+
+    // Methods
+    // --------------------------------------------------------
+    bool hasCollision(const ShapeMask& mask, int column, int row,
+                      const uint64_t overlay[] = nullptr) const;
+    bool placeRow(uint32_t bits, int column, uint64_t& placed) const;
+    int dropDistance(const ShapeMask& mask, int column, int row, int maxRows) const;
+
+    void lockShape(const ShapeMask& mask, int column, int row, int color);
+    int clearLines();
+    void clear();
+
+    void render(sf::RenderWindow& window, sf::Vector2f position, float blockSize);
+
+// Private
+// ------------------------------------------------------------
+private:
+    int _columns;
+    int _rows;
+    uint64_t _fullRow;    // mask of a row with every column filled
+    int _height;          // rows up to the highest filled cell
+
+    uint64_t* _rowMasks;  // by row, 0 is the bottom
+    uint8_t* _colors;     // color index of each cell by row then column
+
+    sf::VertexArray _vertices; // two triangles per filled cell
+};
+
+
+#endif //TETRIS3_WIDEBOARD_H
@@ -0,0 +1,184 @@
+// File: WorkStealingPool.cpp
+//   By: John Holik
+// Desc: Implementation of the work stealing thread pool
+
+#include "WorkStealingPool.h"
+
+// queue of the pool worker running on this thread, -1 for other threads
+static thread_local int currentWorker = -1;
+
+/**
+ * Property constructor starts the workers
+ * @param threads - number of worker threads
+ */
+WorkStealingPool::WorkStealingPool(int threads)
+        : _queued{0}, _nextQueue{0}, _stopping{false} {
+    if(threads < 1){
+        threads = 1;
+    }
+
+    for(int worker = 0; worker < threads; ++worker){
+        TaskQueue* queue = new TaskQueue;
+        queue->head = 0;
+        queue->count = 0;
+        _queues.push_back(queue);
+    }
+
+    for(int worker = 0; worker < threads; ++worker){
+        _threads.emplace_back(&WorkStealingPool::workerLoop, this, worker);
+    }
+} // property
+
+/**
+ * Destructor stops the workers, every job must have finished
+ */
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+
+    for(std::thread& thread : _threads){
+        thread.join();
+    }
+    for(TaskQueue* queue : _queues){
+        delete queue;
+    }
+} // destructor
+
+
+// Private methods
+// ---------------------------------------------
+
+/**
+ * Deal the tasks of a job out to the worker queues, then help run
+ * tasks until every task of the job is done
+ * @param tasks - number of tasks
+ * @param function - called with the context and each task index
+ * @param context - passed to function
+ */
+void WorkStealingPool::runTasks(int tasks, TaskFunction function, void* context) {
+    Job job{function, context, {tasks}, getAllocPhase()};
+
+    int queues = int(_queues.size());
+    int start = _nextQueue.fetch_add(1, std::memory_order_relaxed);
+
+    for(int index = 0; index < tasks; ++index){
+        Task task{&job, index};
+        if(!push((start + index) % queues, task)){
+            // queue full, just run it here
+            function(context, index);
+            job.remaining.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+    }
+    _wake.notify_all();
+
+    while(job.remaining.load(std::memory_order_acquire) > 0){
+        if(!runOneTask(currentWorker)){
+            std::this_thread::yield(); // the last tasks are running elsewhere
+        }
+    }
+} // runTasks
+
+/**
+ * Run tasks until the pool stops, sleeping while there are none
+ * @param worker - index of this worker's queue
+ */
+void WorkStealingPool::workerLoop(int worker) {
+    currentWorker = worker;
+
+    while(true){
+        if(runOneTask(worker)){
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wake.wait(lock, [this] {return _stopping || _queued.load() > 0;});
+        if(_stopping){
+            break;
+        }
+    }
+} // workerLoop
+
+/**
+ * Run one task, the newest from this worker's queue or the oldest
+ * stolen from another
+ * @param worker - queue of the calling worker, -1 if not a worker
+ * @return false if there was nothing to run
+ */
+bool WorkStealingPool::runOneTask(int worker) {
+    Task task{};
+    bool found = worker >= 0 && popNewest(worker, task);
+
+    int queues = int(_queues.size());
+    for(int offset = 1; !found && offset <= queues; ++offset){
+        found = stealOldest((worker + offset + queues) % queues, task);
+    }
+
+    if(found){
+        AllocPhaseScope phase{task.job->phase};
+        task.job->function(task.job->context, task.index);
+        task.job->remaining.fetch_sub(1, std::memory_order_release);
+    }
+    return found;
+} // runOneTask
+
+/**
+ * @param queue - queue to add to
+ * @param task - task to add as the newest
+ * @return false if the queue is full
+ */
+bool WorkStealingPool::push(int queue, const Task& task) {
+    TaskQueue& tasks = *_queues[queue];
+    std::lock_guard<std::mutex> lock(tasks.mutex);
+
+    if(tasks.count == POOL_QUEUE_SIZE){
+        return false;
+    }
+    tasks.tasks[(tasks.head + tasks.count) % POOL_QUEUE_SIZE] = task;
+    ++tasks.count;
+    _queued.fetch_add(1);
+    return true;
+} // push
+
+/**
+ * @param queue - queue to take from
+ * @param task - receives the newest task
+ * @return false if the queue is empty
+ */
+bool WorkStealingPool::popNewest(int queue, Task& task) {
+    TaskQueue& tasks = *_queues[queue];
+    std::lock_guard<std::mutex> lock(tasks.mutex);
+
+    if(tasks.count == 0){
+        return false;
+    }
+    --tasks.count;
+    task = tasks.tasks[(tasks.head + tasks.count) % POOL_QUEUE_SIZE];
+    _queued.fetch_sub(1);
+    return true;
+} // popNewest
+
+/**
+ * @param queue - queue to steal from
+ * @param task - receives the oldest task
+ * @return false if the queue is empty
+ */
+bool WorkStealingPool::stealOldest(int queue, Task& task) {
+    TaskQueue& tasks = *_queues[queue];
+    std::lock_guard<std::mutex> lock(tasks.mutex);
+
+    if(tasks.count == 0){
+        return false;
+    }
+    task = tasks.tasks[tasks.head];
+    tasks.head = (tasks.head + 1) % POOL_QUEUE_SIZE;
+    --tasks.count;
+    _queued.fetch_sub(1);
+    return true;
+} // stealOldest
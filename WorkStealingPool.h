@@ -0,0 +1,89 @@
+// File: WorkStealingPool.h
+//   By: John Holik
+// Desc: Thread pool for splitting a search into small tasks. Each worker
+//       has its own queue, takes its newest task first and steals the
+//       oldest task of another worker when it runs dry. The thread that
+//       starts a job helps run tasks until the job is done, so jobs can
+//       be started from any thread, including from inside another task.
+//       Queues are fixed size rings, nothing is allocated per task.
+//       Tasks run in the allocation phase of the thread that started
+//       the job, so a search started from the update counts as update.
+
+#ifndef TETRIS3_WORKSTEALINGPOOL_H
+#define TETRIS3_WORKSTEALINGPOOL_H
+#include "AllocTracker.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const int POOL_QUEUE_SIZE = 1024; // tasks each worker queue can hold
+
+
+class WorkStealingPool {
+public:
+    // Constructors
+    // --------------------------------------------------------
+    explicit WorkStealingPool(int threads);
+
+    ~WorkStealingPool(); // destructor
+
+    // Accessors
+    // --------------------------------------------------------
+    int getThreads() {return int(_threads.size());}
+
+    // Methods
+    // --------------------------------------------------------
+
+    /**
+     * Run body(task) for task = 0 .. tasks-1 and wait for all of them
+     * @param tasks - number of tasks
+     * @param body - callable taking the task index
+     */
+    template <typename Body>
+    void run(int tasks, Body& body) {
+        runTasks(tasks, [](void* context, int task) {(*static_cast<Body*>(context))(task);}, &body);
+    }
+
+private:
+    typedef void (*TaskFunction)(void* context, int task);
+
+    struct Job{
+        TaskFunction function;
+        void* context;
+        std::atomic<int> remaining;
+        AllocPhase phase;   // of the thread that started the job
+    };
+
+    struct Task{
+        Job* job;
+        int index;
+    };
+
+    struct TaskQueue{
+        std::mutex mutex;
+        Task tasks[POOL_QUEUE_SIZE];
+        int head;   // oldest task, stolen by other workers
+        int count;
+    };
+
+    std::vector<TaskQueue*> _queues; // one per worker
+    std::vector<std::thread> _threads;
+    std::atomic<int> _queued;        // tasks waiting in every queue
+    std::atomic<int> _nextQueue;     // where the next job starts pushing
+
+    std::mutex _sleepMutex;
+    std::condition_variable _wake;
+    bool _stopping;
+
+    void runTasks(int tasks, TaskFunction function, void* context);
+    void workerLoop(int worker);
+    bool runOneTask(int worker);
+    bool push(int queue, const Task& task);
+    bool popNewest(int queue, Task& task);
+    bool stealOldest(int queue, Task& task);
+};
+
+
+#endif //TETRIS3_WORKSTEALINGPOOL_H
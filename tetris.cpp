@@ -6,68 +6,770 @@
 
 #include <SFML/Graphics.hpp>
 #include <iostream>
+#include <random>
+#include <string>
+#include <algorithm>
 #include "tetris.h"
 #include "TetrisBoard.h"
+#include "VersusGame.h"
+#include "GameServer.h"
+#include "ReplayArchive.h"
+#include "TetrisBot.h"
+#include "GameInput.h"
+#include "WeightTuner.h"
+#include "DatasetGenerator.h"
+#include "SnapshotRing.h"
+#include "RollbackGame.h"
+#include "InputQueue.h"
+#include "LatencyProbe.h"
+#include "Trace.h"
+#include "Metrics.h"
+#include "AllocTracker.h"
+#include "HeadlessRunner.h"
+#include "PieceSet.h"
+#include "WideBenchmark.h"
+#include "CoopGame.h"
+#include <cctype>
+#include <csignal>
+#include <cstdlib>
+#include <thread>
 
 // function declarations (prototypes)
 // ------------------------------------------------------------
-bool processEvents(sf::RenderWindow & window, KeyPressedState input[]);
+bool processEvents(sf::RenderWindow & window, KeyPressedState input[], InputQueue* queue = nullptr);
 bool update(KeyPressedState input[], TetrisBoard & board);
 void render(sf::RenderWindow & window, TetrisBoard & gameboard);
+int runVersus(int players, int humans, const EvalWeights& weights);
+int runCoop(int players, int humans, int columns, int rows);
+int runServer(int port, const std::string& socketPath, bool deltaStream);
+int runReplay(const std::string& path);
+int runTuner(int generations, const std::string& checkpointPath);
+int runDataset(const std::string& path, int games, bool randomPolicy, bool compress);
+int runHeadlessGames(int games, uint32_t maxTicks, const std::string& scriptPath, bool randomInput,
+                     int spawnTicks, int gravityTicks, int level, const EvalWeights& weights);
+int runRollback(int player, int localPort, int remotePort, const LagSettings& network, bool botPlayer,
+                const EvalWeights& weights);
+bool takeKey(KeyPressedState input[], sf::Keyboard::Key key);
 
 // function definitions
 // ------------------------------------------------------------
-int main() {
-    //create the game window with width x height with a title
-    sf::RenderWindow window {sf::VideoMode{WIN_WIDTH,
-                                           WIN_HEIGHT}, "Tetris"};
+int main(int argc, char* argv[]) {
+    // records the game when started with --record FILE, adding it to
+    // the games already in FILE
+    ReplayWriter recorder;
+    auto recordArg = std::find(argv + 1, argv + argc, std::string("--record"));
+
+    // --bot lets the AI play every board
+    bool botPlayer = std::find(argv + 1, argv + argc, std::string("--bot")) != argv + argc;
+
+    // --trace FILE writes a Chrome trace of the session when it ends
+    auto traceArg = std::find(argv + 1, argv + argc, std::string("--trace"));
+    if(traceArg != argv + argc && traceArg + 1 != argv + argc){
+        startTrace(*(traceArg + 1));
+        std::atexit([]() {stopTrace();});
+    }
+
+    // --metrics FILE and --metrics-port PORT export Prometheus metrics
+    // for every mode while the program runs
+    auto metricsArg = std::find(argv + 1, argv + argc, std::string("--metrics"));
+    auto metricsPortArg = std::find(argv + 1, argv + argc, std::string("--metrics-port"));
+    MetricsExporter metricsExporter{metricsArg < argv + argc - 1 ? *(metricsArg + 1) : "",
+                                    metricsPortArg < argv + argc - 1 ? std::stoi(*(metricsPortArg + 1)) : 0};
+    if((metricsArg < argv + argc - 1 || metricsPortArg < argv + argc - 1) && !metricsExporter.start()){
+        std::cerr << "can't open the metrics port" << std::endl;
+        return 1;
+    }
+
+    // --pieces FILE plays every mode with the pieces in FILE, it is
+    // read before any board or bot is made (see PieceSet.h)
+    auto piecesArg = std::find(argv + 1, argv + argc, std::string("--pieces"));
+    if(piecesArg < argv + argc - 1 && !loadPieceSet(*(piecesArg + 1))){
+        std::cerr << "can't read pieces from " << *(piecesArg + 1) << std::endl;
+        return 1;
+    }
+    bool customPieces = piecesArg < argv + argc - 1;
+
+    // --bench-wide [ITERATIONS] times the wide board at growing sizes
+    auto benchArg = std::find(argv + 1, argv + argc, std::string("--bench-wide"));
+    if(benchArg != argv + argc){
+        bool counted = benchArg + 1 != argv + argc && std::isdigit((*(benchArg + 1))[0]);
+        runWideBenchmark(counted ? std::stoi(*(benchArg + 1)) : 100000, std::cout);
+        return 0;
+    }
+
+    // --weights CHECKPOINT plays every bot with tuned weights, read
+    // before any mode starts
+    EvalWeights botWeights = DEFAULT_WEIGHTS;
+    auto weightsArg = std::find(argv + 1, argv + argc, std::string("--weights"));
+    if(weightsArg < argv + argc - 1 && !WeightTuner::readBestWeights(*(weightsArg + 1), botWeights)){
+        std::cerr << "can't read weights from " << *(weightsArg + 1) << std::endl;
+        return 1;
+    }
+
+    // --latency measures the time from each key to the frame showing it
+    bool measureLatency = std::find(argv + 1, argv + argc, std::string("--latency")) != argv + argc;
+    InputSettings inputSettings = DEFAULT_INPUT_SETTINGS;
+    int64_t allocBudget = -1;
+    int startLevel = 0;
+    int previewLength = PREVIEW_DEFAULT;
+    int rollouts = 0;
+    int rolloutHorizon = 0;
+
+    // --versus N runs N boards side by side
+    for(int arg = 1; arg < argc - 1; ++arg){
+        if(std::string(argv[arg]) == "--versus"){
+            int players = std::stoi(argv[arg + 1]);
+            return runVersus(players, botPlayer ? 0 : std::min(players, 2), botWeights);
+        }
+        // --coop PLAYERS [COLUMNS [ROWS]] shares one wide board between
+        // the players, each with their own shape
+        if(std::string(argv[arg]) == "--coop"){
+            int players = std::stoi(argv[arg + 1]);
+            int columns = arg + 2 < argc && std::isdigit(argv[arg + 2][0]) ?
+                          std::stoi(argv[arg + 2]) : std::min(players * COOP_COLUMNS_PER_PLAYER, WIDE_MAX_COLUMNS);
+            int rows = arg + 3 < argc && std::isdigit(argv[arg + 3][0]) ? std::stoi(argv[arg + 3]) : COOP_ROWS;
+            return runCoop(players, botPlayer ? 0 : std::min(players, 2), columns, rows);
+        }
+        // --server PORT [SOCKET] [--delta] runs headless games for network
+        // clients, --delta sends them delta streams for spectating
+        if(std::string(argv[arg]) == "--server"){
+            bool deltaStream = std::find(argv + 1, argv + argc, std::string("--delta")) != argv + argc;
+            std::string socketPath = arg + 2 < argc && argv[arg + 2][0] != '-' ? argv[arg + 2] : "";
+            return runServer(std::stoi(argv[arg + 1]), socketPath, deltaStream);
+        }
+        // --replay FILE plays back recorded games
+        if(std::string(argv[arg]) == "--replay"){
+            return runReplay(argv[arg + 1]);
+        }
+        // --tune GENERATIONS [CHECKPOINT] tunes the bot's weights headless
+        if(std::string(argv[arg]) == "--tune"){
+            std::string checkpointPath = arg + 2 < argc ? argv[arg + 2] : "tuner.txt";
+            return runTuner(std::stoi(argv[arg + 1]), checkpointPath);
+        }
+        // --dataset FILE GAMES [random] [raw] writes training samples
+        if(std::string(argv[arg]) == "--dataset" && arg + 2 < argc){
+            if(customPieces){
+                std::cerr << "training samples only hold the standard shapes" << std::endl;
+                return 1;
+            }
+            bool randomPolicy = std::find(argv + arg + 3, argv + argc, std::string("random")) != argv + argc;
+            bool raw = std::find(argv + arg + 3, argv + argc, std::string("raw")) != argv + argc;
+            return runDataset(argv[arg + 1], std::stoi(argv[arg + 2]), randomPolicy, !raw);
+        }
+        // --headless GAMES [TICKS] plays games without a window as fast as
+        // possible, with the bot unless given --script FILE or --random,
+        // --spawn-ticks N and --gravity-ticks N change the board timing,
+        // --level N uses the gravity curve from level N instead
+        if(std::string(argv[arg]) == "--headless"){
+            uint32_t maxTicks = arg + 2 < argc && std::isdigit(argv[arg + 2][0]) ?
+                                uint32_t(std::stoul(argv[arg + 2])) : 1000000u;
+            std::string scriptPath;
+            bool randomInput = false;
+            int spawnTicks = FRAMES_NEW_SHAPE;
+            int gravityTicks = FRAMES_AUTO_MOVE;
+            int level = 0;
+            for(int option = arg + 1; option < argc; ++option){
+                std::string name = argv[option];
+                randomInput = randomInput || name == "--random";
+                if(option + 1 < argc && name == "--script"){
+                    scriptPath = argv[option + 1];
+                }
+                if(option + 1 < argc && name == "--spawn-ticks"){
+                    spawnTicks = std::stoi(argv[option + 1]);
+                }
+                if(option + 1 < argc && name == "--gravity-ticks"){
+                    gravityTicks = std::stoi(argv[option + 1]);
+                }
+                if(option + 1 < argc && name == "--level"){
+                    level = std::stoi(argv[option + 1]);
+                }
+            }
+            return runHeadlessGames(std::stoi(argv[arg + 1]), maxTicks, scriptPath, randomInput,
+                                    spawnTicks, gravityTicks, level, botWeights);
+        }
+        // --rollback PLAYER LOCAL_PORT REMOTE_PORT [DELAY_MS [JITTER_MS [LOSS_PERCENT]]]
+        // plays versus against another game on this machine
+        if(std::string(argv[arg]) == "--rollback" && arg + 3 < argc){
+            LagSettings lag = NO_LAG;
+            lag.delayMs = arg + 4 < argc ? std::stoi(argv[arg + 4]) : 0;
+            lag.jitterMs = arg + 5 < argc ? std::stoi(argv[arg + 5]) : 0;
+            lag.loss = arg + 6 < argc ? std::stof(argv[arg + 6]) / 100.f : 0.f;
+            return runRollback(std::stoi(argv[arg + 1]), std::stoi(argv[arg + 2]),
+                               std::stoi(argv[arg + 3]), lag, botPlayer, botWeights);
+        }
+        // --level N plays with the gravity curve from level N
+        if(std::string(argv[arg]) == "--level"){
+            startLevel = std::stoi(argv[arg + 1]);
+        }
+        // --rollouts N HORIZON has the bot pick each placement by playing
+        // N games of HORIZON shapes on from it instead of searching
+        if(std::string(argv[arg]) == "--rollouts" && arg + 2 < argc){
+            rollouts = std::stoi(argv[arg + 1]);
+            rolloutHorizon = std::stoi(argv[arg + 2]);
+        }
+        // --preview N shows the next N shapes, the bot plans with them too
+        if(std::string(argv[arg]) == "--preview"){
+            previewLength = std::stoi(argv[arg + 1]);
+        }
+        // --das MS and --arr MS set the key repeat timing
+        if(std::string(argv[arg]) == "--das"){
+            inputSettings.dasMs = std::stoi(argv[arg + 1]);
+        }
+        if(std::string(argv[arg]) == "--arr"){
+            inputSettings.arrMs = std::stoi(argv[arg + 1]);
+        }
+        // --alloc-budget N fails the run if an update frame allocates
+        // more than N times, needs a TETRIS_TRACK_ALLOCATIONS build
+        if(std::string(argv[arg]) == "--alloc-budget"){
+            allocBudget = std::stoll(argv[arg + 1]);
+            if(!allocTrackingBuilt()){
+                std::cerr << "--alloc-budget needs a build with TETRIS_TRACK_ALLOCATIONS" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    // opened once the start level is known, it has to match the archive's
+    if(recordArg < argv + argc - 1 && !recorder.open(*(recordArg + 1), startLevel)){
+        std::cerr << "can't record to " << *(recordArg + 1)
+                  << ", it is not an archive of this version, level and piece set" << std::endl;
+        return 1;
+    }
 
     // gameboard grid for the Tetris game
     TetrisBoard gameboard;
+    gameboard.setLevel(startLevel);
+    gameboard.setPreviewLength(previewLength);
+
+    //create the game window with width x height with a title, wider
+    //for the preview panel when more than the next shape is shown
+    int previewWidth = gameboard.getPreviewLength() > 1 ? PREVIEW_WIDTH : 0;
+    sf::RenderWindow window {sf::VideoMode{unsigned(WIN_WIDTH + previewWidth),
+                                           WIN_HEIGHT}, "Tetris"};
 
     // Keyboard state handling
     KeyPressedState keyStates[sf::Keyboard::KeyCount] = {0};
 
+    // game keys are queued with the time they were pressed, the queue
+    // times the repeats of held keys itself
+    InputQueue inputQueue{inputSettings};
+    window.setKeyRepeatEnabled(false);
+    LatencyProbe latency;
+
+    // AI player presses the keys instead when started with --bot
+    WorkStealingPool botPool{botPlayer ? int(std::thread::hardware_concurrency()) : 1};
+    TetrisBot bot{botPool, botWeights};
+    bot.setPreviewLength(previewLength);
+    bot.setRollouts(rollouts, rolloutHorizon);
+    BoardState botView{};
+
+    // every tick is kept so Backspace can undo the last second of play,
+    // except when recording since the replay could not follow it
+    SnapshotRing history;
+    uint32_t tick{0};
+
 
     // Update frame timing
     // --------------------------------------------------------------------
     sf::Clock frameTimer; // frame rate timer
     int lag{0}; // cumulative lag time each frame
+    sf::Clock renderTimer; // time between frames drawn, for the metrics
+
+    // allocations of each frame, the first two seconds of play are warm up
+    AllocReport allocReport{allocBudget, FPS * 2};
 
 
     // main game loop
     // --------------------------------------------------------------------
     bool gameover = false;
     while(!gameover){
+        TRACE_SCOPE("frame");
 
         lag += frameTimer.restart().asMilliseconds();
 
-        gameover = processEvents(window, keyStates);
+        {
+            TRACE_SCOPE("events");
+            AllocPhaseScope phase{ALLOC_EVENTS};
+            gameover = processEvents(window, keyStates, botPlayer ? nullptr : &inputQueue);
+        }
+
+        // after the events so none read this frame is left for the next
+        int64_t frameTime = inputQueue.now();
+
+        if(takeKey(keyStates, sf::Keyboard::Key::BackSpace) && !recorder.isOpen() && !history.isEmpty()){
+            tick = std::max(history.getOldestTick(), tick > uint32_t(FPS) ? tick - FPS : 0u);
+            history.rewind(tick, gameboard);
+        }
 
         // Wait until we get to a frame boundary to update
+        int frameTicks = 0; // updates run this frame, for the alloc report
         while (lag >= FRAME_RATE_MS){
+            TRACE_SCOPE("update");
+            AllocPhaseScope phase{ALLOC_UPDATE};
+
+            history.record(tick++, gameboard);
 
-            gameover = update(keyStates, gameboard);
+            if(botPlayer){
+                gameboard.getState(botView);
+                pressInputs(bot.nextInput(botView), keyStates);
+            }
+            else{
+                // the update stands for the end of its frame, the lag
+                // left after it is how long before now that was
+                int64_t updateTime = frameTime - int64_t(lag - FRAME_RATE_MS) * 1000;
+                int64_t inputTimes[4];
+                unsigned int inputs = inputQueue.takeInputs(updateTime, inputTimes);
+                setInputs(inputs, keyStates);
+
+                for(int key = 0; key < 4 && measureLatency; ++key){
+                    if((inputs >> key) & 1u){
+                        latency.consumed(inputTimes[key], inputQueue.now());
+                    }
+                }
+            }
+
+            recorder.recordFrame(gameboard, keyStates);
+            gameover = update(keyStates, gameboard) || gameover;
 
             lag -= FRAME_RATE_MS; // Reduce the lag by 1 frame
+            ++frameTicks;
+        }
+        {
+            TRACE_SCOPE("render");
+            AllocPhaseScope phase{ALLOC_RENDER};
+            render(window, gameboard);
+        }
+        gameMetrics().framesRendered.add();
+        gameMetrics().frameTime.observe(renderTimer.restart().asMicroseconds());
+        gameMetrics().allocationsPerFrame.set(double(allocReport.endFrame(frameTicks).allocations));
+
+        if(measureLatency){
+            latency.displayed(inputQueue.now());
         }
-        render(window, gameboard);
 
     } // end main game loop
 
     // clean up the main window
     window.close();
 
+    if(measureLatency){
+        latency.report(std::cout);
+    }
+    if(allocTrackingBuilt()){
+        allocReport.report(std::cout);
+    }
+
+    if(allocReport.getOverBudget() > 0){
+        return 1; // the update path allocated more than allowed
+    }
+
     return 0; // return success on exit
 } //end main
 
+/**
+ * Versus mode game loop, same frame timing as a single board
+ * @param players - number of boards to play
+ * @param humans - boards played from the keyboard, the rest are bots
+ * @param weights - evaluation weights of the bots
+ * @return 0 on success
+ */
+int runVersus(int players, int humans, const EvalWeights& weights) {
+    VersusGame versus{players, humans, std::random_device{}(), weights};
+
+    sf::Vector2u size = versus.getWindowSize();
+    sf::RenderWindow window {sf::VideoMode{size.x, size.y}, "Tetris Versus"};
+
+    KeyPressedState keyStates[sf::Keyboard::KeyCount] = {};
+
+    sf::Clock frameTimer;
+    int lag{0};
+
+    bool gameover = false;
+    while(!gameover){
+
+        lag += frameTimer.restart().asMilliseconds();
+
+        gameover = processEvents(window, keyStates);
+
+        while (lag >= FRAME_RATE_MS){
+
+            gameover = versus.Update(keyStates) || gameover;
+
+            lag -= FRAME_RATE_MS;
+        }
+
+        window.clear(BACKGROUND_COLOR);
+        versus.render(window);
+        window.display();
+
+    } // end versus game loop
+
+    window.close();
+
+    return 0;
+} // runVersus
+
+/**
+ * Cooperative mode game loop, same frame timing as a single board
+ * @param players - number of players sharing the board
+ * @param humans - players on the keyboard, the rest press random keys
+ * @param columns - board width
+ * @param rows - board height
+ * @return 0 on success
+ */
+int runCoop(int players, int humans, int columns, int rows) {
+    CoopGame coop{players, humans, columns, rows, std::random_device{}()};
+
+    sf::Vector2u size = coop.getWindowSize();
+    sf::RenderWindow window {sf::VideoMode{size.x, size.y}, "Tetris Co-op"};
+
+    KeyPressedState keyStates[sf::Keyboard::KeyCount] = {};
+
+    sf::Clock frameTimer;
+    int lag{0};
+
+    bool gameover = false;
+    while(!gameover){
+
+        lag += frameTimer.restart().asMilliseconds();
+
+        gameover = processEvents(window, keyStates);
+
+        while (lag >= FRAME_RATE_MS){
+
+            gameover = coop.Update(keyStates) || gameover;
+
+            lag -= FRAME_RATE_MS;
+        }
+
+        window.clear(BACKGROUND_COLOR);
+        coop.render(window);
+        window.display();
+
+    } // end co-op game loop
+
+    std::cout << coop.getLinesCleared() << " lines cleared together" << std::endl;
+    window.close();
+
+    return 0;
+} // runCoop
+
+// server being run, so Ctrl+C can stop it
+static GameServer* runningServer = nullptr;
+
+/**
+ * Headless server, runs until interrupted
+ * @param port - TCP loopback port, 0 for none
+ * @param socketPath - UNIX socket path, empty for none
+ * @param deltaStream - send clients delta streams instead of StateMessages
+ * @return 0 on success
+ */
+int runServer(int port, const std::string& socketPath, bool deltaStream) {
+    GameServer server{port, socketPath, int(std::thread::hardware_concurrency()), deltaStream};
+
+    runningServer = &server;
+    std::signal(SIGINT, [](int) { runningServer->stop(); });
+
+    bool started = server.run();
+
+    runningServer = nullptr;
+    return started ? 0 : 1;
+} // runServer
+
+/**
+ * Headless weight tuning, resumes from the checkpoint if there is one
+ * @param generations - generations to run
+ * @param checkpointPath - progress file, saved after every generation
+ * @return 0 on success
+ */
+int runTuner(int generations, const std::string& checkpointPath) {
+    WorkStealingPool pool{int(std::thread::hardware_concurrency())};
+    WeightTuner tuner{pool, checkpointPath};
+
+    if(tuner.loadCheckpoint()){
+        std::cout << "resuming after generation " << tuner.getGeneration() << std::endl;
+    }
+
+    while(tuner.getGeneration() < generations){
+        tuner.runGeneration(std::cout);
+        if(!tuner.saveCheckpoint()){
+            std::cerr << "can't save " << checkpointPath << std::endl;
+            return 1;
+        }
+    }
+
+    const EvalWeights& best = tuner.getBest();
+    std::cout << "best " << tuner.getBestFitness() << " lines: " << best.height << ' '
+              << best.lines << ' ' << best.holes << ' ' << best.bumpiness << std::endl;
+    return 0;
+} // runTuner
+
+/**
+ * Headless training sample generator
+ * @param path - dataset file to create
+ * @param games - games to play
+ * @param randomPolicy - place shapes at random instead of with the bot
+ * @param compress - compress the sample blocks
+ * @return 0 on success
+ */
+int runDataset(const std::string& path, int games, bool randomPolicy, bool compress) {
+    DatasetWriter writer;
+    if(!writer.open(path, compress)){
+        std::cerr << "can't create " << path << std::endl;
+        return 1;
+    }
+
+    WorkStealingPool pool{int(std::thread::hardware_concurrency())};
+    DatasetGenerator generator{pool, writer, randomPolicy ? DATASET_RANDOM : DATASET_BOT,
+                               std::random_device{}()};
+
+    sf::Clock timer;
+    generator.playGames(games);
+    writer.close();
+    float seconds = timer.getElapsedTime().asSeconds();
+
+    std::cout << writer.getSamples() << " samples, " << writer.getBytes() << " bytes ("
+              << double(writer.getBytes()) / std::max<uint64_t>(writer.getSamples(), 1)
+              << " per sample) in " << seconds << " s, "
+              << writer.getSamples() / seconds << " samples/s" << std::endl;
+    return 0;
+} // runDataset
+
+/**
+ * Headless games, each with seed 1, 2, 3 .. so runs can be compared
+ * @param games - games to play
+ * @param maxTicks - most ticks per game
+ * @param scriptPath - script to play, empty to use the bot
+ * @param randomInput - press random keys instead of using the bot
+ * @param spawnTicks - ticks before each new shape
+ * @param gravityTicks - ticks between automatic moves down
+ * @param level - starting gravity level, 0 for the fixed timing
+ * @param weights - evaluation weights of the bot
+ * @return 0 on success
+ */
+int runHeadlessGames(int games, uint32_t maxTicks, const std::string& scriptPath, bool randomInput,
+                     int spawnTicks, int gravityTicks, int level, const EvalWeights& weights) {
+    WorkStealingPool pool{int(std::thread::hardware_concurrency())};
+
+    uint64_t totalTicks = 0;
+    double totalSeconds = 0.0;
+    for(int game = 0; game < games; ++game){
+        unsigned int seed = unsigned(game + 1);
+        TetrisBoard board{seed};
+        board.setTiming(spawnTicks, gravityTicks);
+        board.setLevel(level);
+
+        // the bot searches to a fixed depth so results don't depend on speed
+        TetrisBot bot{pool, weights};
+        bot.setMaxDepth(2);
+        BotInputSource botInput{bot};
+        ScriptInputSource scriptInput;
+        RandomInputSource randomSource{seed};
+
+        InputSource* input = &botInput;
+        if(!scriptPath.empty()){
+            if(!scriptInput.load(scriptPath)){
+                std::cerr << "can't read script " << scriptPath << std::endl;
+                return 1;
+            }
+            input = &scriptInput;
+        } else if(randomInput){
+            input = &randomSource;
+        }
+
+        HeadlessResult result = runHeadless(board, *input, maxTicks);
+        totalTicks += result.ticks;
+        totalSeconds += result.seconds;
+
+        std::cout << "game " << game + 1 << ": " << result.ticks << " ticks, " << result.lines
+                  << " lines, " << result.shapes << " shapes, " << (result.gameOver ? "game over" : "tick limit")
+                  << ", state " << std::hex << result.stateHash << std::dec << ", "
+                  << result.seconds * 1000.0 << " ms" << std::endl;
+    }
+
+    std::cout << totalTicks << " ticks in " << totalSeconds << " s, "
+              << totalTicks / std::max(totalSeconds, 1e-9) << " ticks/s" << std::endl;
+    return 0;
+} // runHeadlessGames
+
+/**
+ * Rollback versus game against another copy of the game. Both sides
+ * pick the same seed from the two ports
+ * @param player - 0 or 1, the other side must use the other one
+ * @param localPort - UDP port to receive on
+ * @param remotePort - UDP port of the other side
+ * @param network - simulated delay and loss on sent packets
+ * @param botPlayer - the bot plays the local board
+ * @param weights - evaluation weights of the bot
+ * @return 0 on success
+ */
+int runRollback(int player, int localPort, int remotePort, const LagSettings& network, bool botPlayer,
+                const EvalWeights& weights) {
+    LagLink link{network};
+    if(player < 0 || player >= ROLLBACK_PLAYERS || !link.open(localPort, remotePort)){
+        std::cerr << "can't open port " << localPort << std::endl;
+        return 1;
+    }
+
+    unsigned int seed = unsigned(std::min(localPort, remotePort)) << 16 | unsigned(std::max(localPort, remotePort));
+    RollbackGame game{player, seed, link};
+
+    sf::Vector2u size = game.getWindowSize();
+    sf::RenderWindow window {sf::VideoMode{size.x, size.y}, "Tetris Rollback"};
+
+    KeyPressedState keyStates[sf::Keyboard::KeyCount] = {};
+    const sf::Keyboard::Key inputKeys[] = {sf::Keyboard::Key::Space, sf::Keyboard::Key::A,
+                                           sf::Keyboard::Key::D, sf::Keyboard::Key::S};
+
+    WorkStealingPool botPool{botPlayer ? int(std::thread::hardware_concurrency()) : 1};
+    TetrisBot bot{botPool, weights};
+    BoardState botView{};
+
+    sf::Clock frameTimer;
+    int lag{0};
+
+    bool closing = false;
+    while(!closing){
+
+        lag += frameTimer.restart().asMilliseconds();
+
+        closing = processEvents(window, keyStates);
+
+        while (lag >= FRAME_RATE_MS){
+            unsigned int input = INPUT_NONE;
+            if(botPlayer){
+                game.getState(player, botView);
+                input = bot.nextInput(botView);
+            }
+            else{
+                for(int key = 0; key < 4; ++key){
+                    input |= takeKey(keyStates, inputKeys[key]) ? 1u << key : 0u;
+                }
+            }
+
+            // keeps exchanging packets after the game is over so the
+            // other side can confirm it too
+            game.Update(input);
+
+            lag -= FRAME_RATE_MS;
+        }
+
+        window.clear(BACKGROUND_COLOR);
+        game.render(window);
+        window.display();
+
+    } // end rollback game loop
+
+    window.close();
+
+    std::cout << game.getTick() << " ticks, " << game.getRollbacks() << " rollbacks, "
+              << game.getResimulated() << " ticks run again, " << game.getStalls() << " stalls" << std::endl;
+    return 0;
+} // runRollback
+
+/**
+ * Check for a key released on the replay viewer and clear it
+ * @param input - key states from processEvents()
+ * @param key - key to check
+ * @return true if the key was released
+ */
+bool takeKey(KeyPressedState input[], sf::Keyboard::Key key) {
+    bool released = input[key].current;
+    input[key] = {false, false};
+    return released;
+} // takeKey
+
+/**
+ * Replay viewer. Space plays or pauses, Left/Right jump a second
+ * back or forward and Up/Down pick the previous or next game
+ * @param path - replay archive
+ * @return 0 on success
+ */
+int runReplay(const std::string& path) {
+    ReplayArchive archive;
+    if(!archive.open(path) || archive.getGames() == 0){
+        std::cerr << "can't read replays from " << path << std::endl;
+        return 1;
+    }
+    if(archive.getPieceSet() != pieceSet().hash()){
+        std::cerr << path << " was recorded with another piece set, play it with the same --pieces" << std::endl;
+        return 1;
+    }
+
+    sf::RenderWindow window {sf::VideoMode{WIN_WIDTH, WIN_HEIGHT}, "Tetris Replay"};
+
+    TetrisBoard board;
+    board.setLevel(archive.getStartLevel()); // keyframes don't hold it
+    KeyPressedState keyStates[sf::Keyboard::KeyCount] = {};
+    KeyPressedState replayKeys[sf::Keyboard::KeyCount] = {};
+
+    int game = 0;
+    int frame = 0;
+    int shownGame = game;
+    bool playing = true;
+    archive.seek(game, frame, board, replayKeys);
+
+    sf::Clock frameTimer;
+    int lag{0};
+
+    bool closing = false;
+    while(!closing){
+
+        lag += frameTimer.restart().asMilliseconds();
+
+        closing = processEvents(window, keyStates);
+
+        int seekTo = frame;
+        if(takeKey(keyStates, sf::Keyboard::Key::Space)){
+            playing = !playing;
+        }
+        if(takeKey(keyStates, sf::Keyboard::Key::Left)){
+            seekTo = std::max(0, frame - FPS);
+        }
+        if(takeKey(keyStates, sf::Keyboard::Key::Right)){
+            seekTo = std::min(archive.getFrames(game), frame + FPS);
+        }
+        if(takeKey(keyStates, sf::Keyboard::Key::Up) && game > 0){
+            --game;
+            seekTo = 0;
+        }
+        if(takeKey(keyStates, sf::Keyboard::Key::Down) && game < archive.getGames() - 1){
+            ++game;
+            seekTo = 0;
+        }
+
+        // only a jump restores a keyframe
+        if(seekTo != frame || game != shownGame){
+            frame = seekTo;
+            shownGame = game;
+            archive.seek(game, frame, board, replayKeys);
+        }
+
+        // playing on is one update a frame with the recorded keys
+        while (lag >= FRAME_RATE_MS){
+            if(playing && archive.step(game, frame, board, replayKeys)){
+                ++frame;
+            }
+            lag -= FRAME_RATE_MS;
+        }
+
+        render(window, board);
+
+    } // end replay loop
+
+    window.close();
+
+    return 0;
+} // runReplay
+
 /**
  * Process window and keyboard events
  * @param window - reference to the main window
  * @param input - prior and current state of each keyboard key
+ * @param queue - takes the game keys instead when given
  * @return true = window closing
  */
-bool processEvents(sf::RenderWindow & window, KeyPressedState input[]){
+bool processEvents(sf::RenderWindow & window, KeyPressedState input[], InputQueue* queue){
     bool closing = false;
 
     sf::Event event;
@@ -76,6 +778,9 @@ bool processEvents(sf::RenderWindow & window, KeyPressedState input[]){
         if(event.type == sf::Event::Closed){
             closing = true; // Return closing true
         }
+        else if(queue && queue->push(event)){
+            // game key presses and releases are timestamped in the queue
+        }
         // Check for keyboard events
         // Only watching for key being released
         else if (event.type == sf::Event::KeyReleased){
@@ -125,6 +830,11 @@ void render(sf::RenderWindow & window, TetrisBoard & board) {
     // draw the gameboard grid
     board.render(window);
 
+    // the shapes coming up right of the board
+    if(board.getPreviewLength() > 1){
+        board.renderPreview(window, sf::Vector2f(WIN_WIDTH, GRID_TOP));
+    }
+
     window.display();
 
 } // end render
@@ -32,6 +32,7 @@ const int START_CELL_ROW = 20; // top row 21, array index 20
 
 const sf::Color BACKGROUND_COLOR = sf::Color::Black;
 const sf::Color GRID_COLOR = sf::Color(0xD3, 0xD3, 0xD3, 50); // light gray 50/255 ~20% Opacity
+const sf::Color GARBAGE_COLOR = sf::Color(0x80, 0x80, 0x80); // gray rows sent by an opponent
 
 struct KeyPressedState{   // maintain state of each input key across frames
     bool prior;           // state of key in prior frame: Pressed = true